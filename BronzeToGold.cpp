@@ -15,6 +15,9 @@ using namespace std;
 
 #define POD_MAXIMUM_THRUST 100
 #define POD_COLLIDER_SIZE 400.0f
+#define POD_MAXIMUM_ROTATION 18.0f
+#define POD_FRICTION 0.85f
+#define POD_BOOST_THRUST 650
 
 #define BOOST_THRESHOLD_DISTANCE_TO_CHECKPOINT 1500.0f
 #define BOOST_THRESHOLD_DISTANCE_TO_OPPONENT 600.0f
@@ -26,10 +29,25 @@ using namespace std;
 #define THRUST_DISTANCE_BEFORE_BRAKING 1200.0f
 #define THRUST_MINIMUM_BRACKING_MULTIPLIER 0.5f
 
+#define LEARNED_MAP_MAXIMUM_CHECKPOINTS 8
+
+#define SEARCH_DEPTH 3 // Every move combination is tried up to this depth, then the pod aims at the checkpoints
+#define SEARCH_ROLLOUT_TURNS 3
+#define SEARCH_ROLLOUT_SPEED_OFFSET 3.0f
+#define SEARCH_CHECKPOINT_SCORE 50000.0f
+#define SEARCH_LATE_PASS_PENALTY 1000.0f // Per turn, without it the pod keeps postponing a checkpoint it can pass anyway
+#define SEARCH_TARGET_DISTANCE 10000.0f
+
 #define FLOAT_COMPARE(_a, _b) (fabs(_a - _b) < 0.000001f)
 #define DEG_TO_RAD(angleDeg) (angleDeg * PI / 180.0f)
 #define RAD_TO_DEG(angleRad) (angleRad * 180.0f / PI)
 
+#ifdef BRONZE_TO_GOLD_SILENT
+#define DEBUG_LOG if (true) {} else cerr
+#else
+#define DEBUG_LOG cerr
+#endif
+
 #pragma region Vector2
 
 class Vector2
@@ -185,6 +203,55 @@ ostream& operator<<(ostream& _output, const Vector2& _v)
 
 #pragma endregion
 
+#pragma region Input and Output Structures
+
+struct TurnInput
+{
+	Vector2 m_position = Vector2::Zero;
+	Vector2 m_nextCheckpointPosition = Vector2::Zero;
+	float m_nextCheckpointDistance = 0.0f;
+	float m_nextCheckpointAngle = 0.0f;
+	Vector2 m_opponentPosition = Vector2::Zero;
+};
+
+struct PodCommand
+{
+	Vector2 m_target = Vector2::Zero;
+	int m_thrust = 0;
+	bool m_useBoost = false;
+	string m_hoverText = "";
+};
+
+#pragma endregion
+
+#pragma region Stream Adapter
+
+TurnInput ReadTurnInput(istream& _stream)
+{
+	TurnInput turnInput;
+	_stream >> turnInput.m_position.m_x >> turnInput.m_position.m_y >>
+		turnInput.m_nextCheckpointPosition.m_x >> turnInput.m_nextCheckpointPosition.m_y >>
+		turnInput.m_nextCheckpointDistance >> turnInput.m_nextCheckpointAngle;
+	_stream.ignore();
+	_stream >> turnInput.m_opponentPosition.m_x >> turnInput.m_opponentPosition.m_y;
+	_stream.ignore();
+	return turnInput;
+}
+
+void WriteCommand(ostream& _stream, const PodCommand& _command)
+{
+	if (_command.m_useBoost)
+	{
+		_stream << _command.m_target << " " << BOOST_KEYWORD << " " << _command.m_hoverText << endl;
+	}
+	else
+	{
+		_stream << _command.m_target << " " << _command.m_thrust << " " << _command.m_hoverText << endl;
+	}
+}
+
+#pragma endregion
+
 #pragma region Checkpoint
 
 class Checkpoint
@@ -197,6 +264,191 @@ public:
 };
 
 
+#pragma endregion
+
+#pragma region Learned Map
+
+// The league only gives the next checkpoint, the map is recorded while the first lap is raced
+class LearnedMap
+{
+public:
+
+	void Record(const Vector2& _checkpointPosition);
+	int FindIndex(const Vector2& _checkpointPosition) const;
+
+	inline bool IsComplete() const { return m_isComplete; }
+	inline const Vector2& GetCheckpoint(int _index) const { return m_checkpoints[_index % m_count]; }
+
+private:
+
+	Vector2 m_checkpoints[LEARNED_MAP_MAXIMUM_CHECKPOINTS];
+	int m_count = 0;
+	bool m_isComplete = false;
+};
+
+void LearnedMap::Record(const Vector2& _checkpointPosition)
+{
+	if (m_isComplete) return;
+	if (m_count > 0 && m_checkpoints[m_count - 1] == _checkpointPosition) return;
+
+	// The lap is closed when the first recorded checkpoint comes back
+	if (m_count > 1 && m_checkpoints[0] == _checkpointPosition)
+	{
+		m_isComplete = true;
+		return;
+	}
+	if (m_count == LEARNED_MAP_MAXIMUM_CHECKPOINTS) return;
+	m_checkpoints[m_count++] = _checkpointPosition;
+}
+
+int LearnedMap::FindIndex(const Vector2& _checkpointPosition) const
+{
+	for (int iCheckpoint = 0; iCheckpoint < m_count; iCheckpoint++)
+	{
+		if (m_checkpoints[iCheckpoint] == _checkpointPosition) return iCheckpoint;
+	}
+	return 0;
+}
+
+#pragma endregion
+
+#pragma region Race Search
+
+float NormalizeAngle(float _angle)
+{
+	while (_angle > 180.0f) _angle -= 360.0f;
+	while (_angle <= -180.0f) _angle += 360.0f;
+	return _angle;
+}
+
+// Rotation the referee applies to face the target, in degres
+float ComputeRotation(float _facingAngle, const Vector2& _position, const Vector2& _target)
+{
+	if (_position == _target) return 0.0f;
+	float targetAngle = RAD_TO_DEG(atan2f(_target.m_y - _position.m_y, _target.m_x - _position.m_x));
+	return clamp(NormalizeAngle(targetAngle - _facingAngle), -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION);
+}
+
+struct SearchPod
+{
+	Vector2 m_position = Vector2::Zero;
+	Vector2 m_speed = Vector2::Zero;
+	float m_angle = 0.0f;
+	int m_nextCheckpointIndex = 0;
+	int m_checkpointPassedCount = 0;
+	int m_turn = 0;
+	int m_lastPassTurn = 0;
+};
+
+struct SearchMove
+{
+	float m_rotation = 0.0f;
+	int m_thrust = 0;
+};
+
+// Exhaustive search of the next moves on the learned map, the opponent is ignored.
+// A few thousand pod steps, far below a millisecond.
+class RaceSearch
+{
+public:
+
+	static PodCommand FindCommand(const LearnedMap& _map, const SearchPod& _pod, bool _canUseBoost);
+
+private:
+
+	static float SearchMoves(const LearnedMap& _map, const SearchPod& _pod, int _depth);
+	static void SimulateTurn(const LearnedMap& _map, SearchPod& _pod, const SearchMove& _move);
+	static float Evaluate(const LearnedMap& _map, const SearchPod& _pod);
+};
+
+const SearchMove SEARCH_MOVES[] =
+{
+	{ -POD_MAXIMUM_ROTATION, POD_MAXIMUM_THRUST }, { 0.0f, POD_MAXIMUM_THRUST }, { POD_MAXIMUM_ROTATION, POD_MAXIMUM_THRUST },
+	{ -POD_MAXIMUM_ROTATION, POD_MAXIMUM_THRUST / 2 }, { 0.0f, POD_MAXIMUM_THRUST / 2 }, { POD_MAXIMUM_ROTATION, POD_MAXIMUM_THRUST / 2 },
+	{ -POD_MAXIMUM_ROTATION, 0 }, { 0.0f, 0 }, { POD_MAXIMUM_ROTATION, 0 },
+};
+
+PodCommand RaceSearch::FindCommand(const LearnedMap& _map, const SearchPod& _pod, bool _canUseBoost)
+{
+	SearchMove bestMove;
+	float bestScore = -INFINITY;
+	bool isBestBoost = false;
+
+	// The boost is only tried on the first move, it is used once per race
+	for (int iMove = -1; iMove < (int)size(SEARCH_MOVES); iMove++)
+	{
+		if (iMove < 0 && false == _canUseBoost) continue;
+		SearchMove move = iMove < 0 ? SearchMove{ 0.0f, POD_BOOST_THRUST } : SEARCH_MOVES[iMove];
+
+		SearchPod pod = _pod;
+		SimulateTurn(_map, pod, move);
+		float score = SearchMoves(_map, pod, 1);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestMove = move;
+			isBestBoost = iMove < 0;
+		}
+	}
+
+	float angle = DEG_TO_RAD((_pod.m_angle + bestMove.m_rotation));
+	PodCommand command;
+	command.m_target = _pod.m_position + Vector2(cosf(angle), sinf(angle)) * SEARCH_TARGET_DISTANCE;
+	command.m_thrust = isBestBoost ? POD_MAXIMUM_THRUST : bestMove.m_thrust;
+	command.m_useBoost = isBestBoost;
+	command.m_hoverText = "SEARCHING";
+	return command;
+}
+
+float RaceSearch::SearchMoves(const LearnedMap& _map, const SearchPod& _pod, int _depth)
+{
+	if (_depth == SEARCH_DEPTH)
+	{
+		// The end of the horizon is played by the heuristic, aiming at the checkpoints against the speed
+		SearchPod pod = _pod;
+		for (int iTurn = 0; iTurn < SEARCH_ROLLOUT_TURNS; iTurn++)
+		{
+			Vector2 target = _map.GetCheckpoint(pod.m_nextCheckpointIndex) - pod.m_speed * SEARCH_ROLLOUT_SPEED_OFFSET;
+			float rotation = ComputeRotation(pod.m_angle, pod.m_position, target);
+			SimulateTurn(_map, pod, SearchMove{ rotation, POD_MAXIMUM_THRUST });
+		}
+		return Evaluate(_map, pod);
+	}
+
+	float bestScore = -INFINITY;
+	for (const SearchMove& move : SEARCH_MOVES)
+	{
+		SearchPod pod = _pod;
+		SimulateTurn(_map, pod, move);
+		bestScore = max(bestScore, SearchMoves(_map, pod, _depth + 1));
+	}
+	return bestScore;
+}
+
+void RaceSearch::SimulateTurn(const LearnedMap& _map, SearchPod& _pod, const SearchMove& _move)
+{
+	_pod.m_angle = NormalizeAngle(_pod.m_angle + _move.m_rotation);
+	float angle = DEG_TO_RAD(_pod.m_angle);
+	_pod.m_speed += Vector2(cosf(angle), sinf(angle)) * (float)_move.m_thrust;
+	_pod.m_position += _pod.m_speed;
+
+	if (Vector2::SquareDistance(_pod.m_position, _map.GetCheckpoint(_pod.m_nextCheckpointIndex)) < CHECKPOINT_RADIUS * CHECKPOINT_RADIUS)
+	{
+		_pod.m_nextCheckpointIndex++;
+		_pod.m_checkpointPassedCount++;
+		_pod.m_lastPassTurn = _pod.m_turn;
+	}
+	_pod.m_turn++;
+
+	_pod.m_speed = Vector2(truncf(_pod.m_speed.m_x * POD_FRICTION), truncf(_pod.m_speed.m_y * POD_FRICTION));
+	_pod.m_position = Vector2(roundf(_pod.m_position.m_x), roundf(_pod.m_position.m_y));
+}
+
+float RaceSearch::Evaluate(const LearnedMap& _map, const SearchPod& _pod)
+{
+	return _pod.m_checkpointPassedCount * SEARCH_CHECKPOINT_SCORE - _pod.m_lastPassTurn * SEARCH_LATE_PASS_PENALTY - Vector2::Distance(_pod.m_position, _map.GetCheckpoint(_pod.m_nextCheckpointIndex));
+}
+
 #pragma endregion
 
 #pragma region Pod
@@ -205,7 +457,7 @@ class Pod
 {
 public:
 
-	virtual void ReceiveInput();
+	virtual void ApplyInput(const Vector2& _position);
 	virtual void UpdateDebug() {};
 
 	inline Vector2 GetPosition() const { return m_position; }
@@ -216,10 +468,9 @@ protected:
 	bool m_canUseBoost = true;
 };
 
-void Pod::ReceiveInput()
+void Pod::ApplyInput(const Vector2& _position)
 {
-	cin >> m_position.m_x >> m_position.m_y;
-	cin.ignore();
+	m_position = _position;
 }
 
 #pragma endregion
@@ -230,8 +481,9 @@ class PlayerPod : public Pod
 {
 public:
 
-	void ReceiveInput() override;
+	void ApplyInput(const TurnInput& _turnInput);
 
+	void UpdateMap();
 	void UpdateOpponentInteraction(const Pod& _opponent);
 	void UpdateThrust();
 	void UpdateSpeed();
@@ -239,7 +491,7 @@ public:
 	void UpdateTarget();
 	void UpdateHoverText();
 
-	void SendOutput();
+	PodCommand ComputeCommand();
 
 private:
 
@@ -254,17 +506,40 @@ private:
 	Vector2 m_lastPosition = Vector2::Zero;
 	Vector2 m_speed = Vector2::Zero;
 	Vector2 m_target = Vector2::Zero;
+	LearnedMap m_map;
+	float m_facingAngle = 0.0f;
 
 	bool m_isTurning = false;
 	bool m_isBraking = false;
+	bool m_isFirstFrame = true;
 };
 
-void PlayerPod::ReceiveInput()
+void PlayerPod::ApplyInput(const TurnInput& _turnInput)
 {
-	cin >> m_position.m_x >> m_position.m_y >>
-		m_nextCheckpoint.m_position.m_x >> m_nextCheckpoint.m_position.m_y >>
-		m_nextCheckpoint.m_distance >> m_nextCheckpoint.m_angle;
-	cin.ignore();
+	m_position = _turnInput.m_position;
+	m_nextCheckpoint.m_position = _turnInput.m_nextCheckpointPosition;
+	m_nextCheckpoint.m_distance = _turnInput.m_nextCheckpointDistance;
+	m_nextCheckpoint.m_angle = _turnInput.m_nextCheckpointAngle;
+}
+
+void PlayerPod::UpdateMap()
+{
+	m_map.Record(m_nextCheckpoint.m_position);
+
+	// The facing is not given, it comes back from the signed angle to the checkpoint.
+	// Both signs are tried, the one closest to the rotation of the last turn is kept.
+	float checkpointAngle = RAD_TO_DEG(atan2f(m_nextCheckpoint.m_position.m_y - m_position.m_y, m_nextCheckpoint.m_position.m_x - m_position.m_x));
+	float facingAngle = NormalizeAngle(checkpointAngle - m_nextCheckpoint.m_angle);
+	float mirroredFacingAngle = NormalizeAngle(checkpointAngle + m_nextCheckpoint.m_angle);
+	if (false == m_isFirstFrame)
+	{
+		float predictedAngle = m_facingAngle + ComputeRotation(m_facingAngle, m_lastPosition, m_target);
+		if (abs(NormalizeAngle(mirroredFacingAngle - predictedAngle)) < abs(NormalizeAngle(facingAngle - predictedAngle)))
+		{
+			facingAngle = mirroredFacingAngle;
+		}
+	}
+	m_facingAngle = facingAngle;
 }
 
 void PlayerPod::UpdateThrust()
@@ -280,40 +555,39 @@ void PlayerPod::UpdateThrust()
 	// Slow down when the player is turning to the next checkpoint
 	turningMultiplier = (1.0f - m_nextCheckpoint.m_angle / THRUST_ANGLE_BEFORE_TURNING);
 	turningMultiplier = clamp(turningMultiplier, 0.0f, 1.0f);
-	cerr << "Turning Multiplier : " << turningMultiplier << endl;
+	DEBUG_LOG << "Turning Multiplier : " << turningMultiplier << endl;
 	m_isTurning = turningMultiplier <= 0.80f;
 
 	// Slow down as the player get closer to the checkpoint.
 	brakingMultiplier = m_nextCheckpoint.m_distance / THRUST_DISTANCE_BEFORE_BRAKING;
 	brakingMultiplier = clamp(brakingMultiplier, THRUST_MINIMUM_BRACKING_MULTIPLIER, 1.0f);
-	cerr << "Braking Multiplier : " << brakingMultiplier << endl;
+	DEBUG_LOG << "Braking Multiplier : " << brakingMultiplier << endl;
 	m_isBraking = brakingMultiplier <= 0.80f;
 
 	m_thrust = newThrust * turningMultiplier * brakingMultiplier;
-	cerr << "Thrust : " << m_thrust << endl;
+	DEBUG_LOG << "Thrust : " << m_thrust << endl;
 }
 
 void PlayerPod::UpdateSpeed()
 {
 	m_speed = m_position - m_lastPosition;
 	m_lastPosition = m_position;
-	cerr << "Speed : " << "x:" << m_speed.m_x << "y:" << m_speed.m_y << endl;
+	DEBUG_LOG << "Speed : " << "x:" << m_speed.m_x << "y:" << m_speed.m_y << endl;
 }
 
 void PlayerPod::UpdateNextCheckpoint()
 {
-	cerr << "Angle to checkpoint : " << m_nextCheckpoint.m_angle << endl;
-	cerr << "Distance to checkpoint : " << m_nextCheckpoint.m_distance << endl;
+	DEBUG_LOG << "Angle to checkpoint : " << m_nextCheckpoint.m_angle << endl;
+	DEBUG_LOG << "Distance to checkpoint : " << m_nextCheckpoint.m_distance << endl;
 	m_nextCheckpoint.m_angle = abs(m_nextCheckpoint.m_angle);
 }
 
 void PlayerPod::UpdateTarget()
 {
 	// Prevent the player from going in the wrong direction at the start
-	static bool isFirstFrame = true;
-	if (isFirstFrame)
+	if (m_isFirstFrame)
 	{
-		isFirstFrame = false;
+		m_isFirstFrame = false;
 		m_target = m_nextCheckpoint.m_position;
 		return;
 	}
@@ -349,19 +623,33 @@ void PlayerPod::UpdateOpponentInteraction(const Pod& _opponent)
 	m_playerToTarget = m_target - m_position;
 	m_playerToOpponent = _opponent.GetPosition() - m_position;
 	m_dotOpponentPlayer = Vector2::Dot(m_playerToTarget.Normalized(), m_playerToOpponent.Normalized());
-	cerr << "Dot between opponent and player : " << m_dotOpponentPlayer << endl;
+	DEBUG_LOG << "Dot between opponent and player : " << m_dotOpponentPlayer << endl;
 }
 
-void PlayerPod::SendOutput()
+PodCommand PlayerPod::ComputeCommand()
 {
-	if (CheckShouldBoost() == true)
+	// From the second lap the whole map is known, the moves are searched instead
+	if (m_map.IsComplete())
 	{
-		cout << m_target << " " << BOOST_KEYWORD << " " << m_hoverText << endl;
-	}
-	else
-	{
-		cout << m_target << " " << m_thrust << " " << m_hoverText << endl;
+		SearchPod pod;
+		pod.m_position = m_position;
+		pod.m_speed = Vector2(truncf(m_speed.m_x * POD_FRICTION), truncf(m_speed.m_y * POD_FRICTION));
+		pod.m_angle = m_facingAngle;
+		pod.m_nextCheckpointIndex = m_map.FindIndex(m_nextCheckpoint.m_position);
+
+		PodCommand command = RaceSearch::FindCommand(m_map, pod, m_canUseBoost);
+		if (command.m_useBoost) m_canUseBoost = false;
+		m_target = command.m_target;
+		m_hoverText = command.m_hoverText;
+		return command;
 	}
+
+	PodCommand command;
+	command.m_target = m_target;
+	command.m_thrust = m_thrust;
+	command.m_useBoost = CheckShouldBoost();
+	command.m_hoverText = m_hoverText;
+	return command;
 }
 
 bool PlayerPod::CheckShouldBoost()
@@ -390,24 +678,58 @@ bool PlayerPod::CheckShouldBoost()
 
 #pragma endregion
 
+#pragma region Bronze Bot
+
+// The whole bot behind an init/step interface on plain structures, main only adapts it to the referee streams
+class BronzeBot
+{
+public:
+
+	void Init(); // These leagues give no map, it only forgets the previous race
+	PodCommand Step(const TurnInput& _turnInput);
+
+private:
+
+	PlayerPod m_playerPod;
+	Pod m_opponent;
+};
+
+void BronzeBot::Init()
+{
+	m_playerPod = PlayerPod();
+	m_opponent = Pod();
+}
+
+PodCommand BronzeBot::Step(const TurnInput& _turnInput)
+{
+	m_playerPod.ApplyInput(_turnInput);
+	m_opponent.ApplyInput(_turnInput.m_opponentPosition);
+
+	m_playerPod.UpdateMap();
+	m_playerPod.UpdateThrust();
+	m_playerPod.UpdateSpeed();
+	m_playerPod.UpdateNextCheckpoint();
+	m_playerPod.UpdateTarget();
+	m_playerPod.UpdateOpponentInteraction(m_opponent);
+	m_playerPod.UpdateHoverText();
+
+	return m_playerPod.ComputeCommand();
+}
+
+#pragma endregion
+
+#ifndef BRONZE_TO_GOLD_NO_MAIN // Tools embed this file and drive BronzeBot themselves
+
 int main()
 {
-	PlayerPod playerPod;
-	Pod opponent;
+	BronzeBot bot;
+	bot.Init();
 
 	bool isRunning = true;
 	while (isRunning)
 	{
-		playerPod.ReceiveInput();
-		opponent.ReceiveInput();
-
-		playerPod.UpdateThrust();
-		playerPod.UpdateSpeed();
-		playerPod.UpdateNextCheckpoint();
-		playerPod.UpdateTarget();
-		playerPod.UpdateOpponentInteraction(opponent);
-		playerPod.UpdateHoverText();
-
-		playerPod.SendOutput();
+		WriteCommand(cout, bot.Step(ReadTurnInput(cin)));
 	}
 }
+
+#endif
@@ -5,7 +5,13 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <cstdint>
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <limits>
 
 using namespace std;
 using namespace std::chrono;
@@ -23,24 +29,142 @@ using namespace std::chrono;
 #define RAD_TO_DEG(angleRad) (angleRad * 180.0f / PI)
 #define LERP(a, b, t) (a * (1.0f - t)) + (b * t);
 
-#define DISTANCE_BEFORE_COLLIDING 16000000
+#ifdef GOLD_SILENT
+#define DEBUG_LOG if (true) {} else cerr
+#else
+#define DEBUG_LOG cerr
+#endif
+
 #define TARGET_DISTANCE 1000.0f
 
-#define NB_TURN_SIMULATED 4
+// Values generated by Tools/Tuner.cpp override the hand-picked ones below
+#if defined(__has_include)
+#if __has_include("GoldParameters.h")
+#include "GoldParameters.h"
+#endif
+#endif
+
+#define NB_TURN_SIMULATED_MIN 2
+#ifndef NB_TURN_SIMULATED_MAX
+#define NB_TURN_SIMULATED_MAX 8 // Size of every solution, 12 gives the macro-action genome a longer horizon
+#endif
+#ifndef NB_TURN_SIMULATED
+#define NB_TURN_SIMULATED 4 // Horizon of an ordinary situation, the solver adapts it every turn
+#endif
+#ifndef SOLUTIONS_COUNT
 #define SOLUTIONS_COUNT 6
+#endif
 #define TIME_ALLOCATED_PER_TURN 65
+#define SIMULATION_BUDGET 0 // Simulated turns searched per turn instead of TIME_ALLOCATED_PER_TURN, 0 searches on the clock
+#define DETERMINISTIC_SEED 12345u // Seed of the first turn when searching on a simulation budget
+#define PONDER_MAXIMUM_TIME 1000 // Safety net if the next input never comes
+#define WATCHDOG_DEADLINE 70 // After this time the fallback outputs are sent whatever the search is doing
+#define FIRST_TURN_WATCHDOG_DEADLINE 900 // The first turn is given 1000ms by the referee
 #define ROTATION_CHANGE_BY_MUTATION 26.0f
 
 #define THRUST_CHANGE_BY_MUTATION 26.0f
 
-#define PROBABILITY_TO_USE_SHIELD 20
+#define PROBABILITY_TO_USE_SHIELD 10 // Only the blocker generates shields
+#ifndef PROBABILITY_TO_USE_BOOST
 #define PROBABILITY_TO_USE_BOOST 30
+#endif
+#ifndef PROBABILITY_TO_FULL_THROTTLE
 #define PROBABILITY_TO_FULL_THROTTLE 75
+#endif
+#ifndef PROBABILITY_TO_NO_THROTTLE
 #define PROBABILITY_TO_NO_THROTTLE 90
+#endif
 
+#ifndef EVALUATION_CHECKPOINT_FACTOR
 #define EVALUATION_CHECKPOINT_FACTOR 40000
-
-#define POD_NB_TO_SIMULATE 1
+#endif
+
+// Horizon selection
+#define EVALUATIONS_PER_TURN 20000 // The horizon is limited so that the budget keeps this many evaluations
+#define HORIZON_RATE_SMOOTHING 0.2f
+#define HORIZON_STRAIGHT_DISTANCE 4000.0f
+#define HORIZON_STRAIGHT_ANGLE 30.0f
+#define HORIZON_NEAR_CHECKPOINT_TURNS 3.0f
+#define HORIZON_CROWDED_DISTANCE 2500.0f
+
+// Closed-form controller of BronzeToGold.cpp, used to seed the search
+#define HEURISTIC_SEEDS_COUNT 1
+#define HEURISTIC_SOFT_DEADLINE_SHARE 60 // Percentage of the search after which a search that found nothing better than the heuristic plan gives up
+#define PROBABILITY_TO_APPEND_HEURISTIC 50
+#define THRUST_ANGLE_BEFORE_TURNING 80.0f
+#define THRUST_DISTANCE_BEFORE_BRAKING 1200.0f
+#define THRUST_MINIMUM_BRACKING_MULTIPLIER 0.5f
+#define TARGET_SPEED_OFFSET_MULTIPLIER -3.0f
+#define BOOST_THRESHOLD_DISTANCE_TO_CHECKPOINT 1500.0f
+#define BOOST_THRESHOLD_ANGLE 1.0f
+
+// Exact search of the fewest turns to the finish line, once it is close enough
+#define ENDGAME_MAXIMUM_DEPTH 6 // Never above NB_TURN_SIMULATED_MAX
+#define ENDGAME_TIME_SHARE 50 // Percentage of the search time, the genetic search gets the rest when nothing is found
+#define ENDGAME_ROTATION_STEP 9
+#define ENDGAME_SCORE 100000000 // Above any evaluation, minus the turns needed
+
+// First turn analysis of the map
+#define MAP_ANALYSIS_TIME 600
+#define MAP_ANALYSIS_MAXIMUM_TURNS 300 // Laps are abandoned after this many turns
+#define OPENING_BOOK_TURNS 10
+
+// Layouts optimized offline are recognized despite the rotation and the small moves of the checkpoints by the arena
+#define KNOWN_MAP_TOLERANCE 100.0f
+
+#define POD_NB_TO_SIMULATE 2
+
+// Roles of the controlled pods, each one has its own search and its own share of the turn
+#define RACER_POD_INDEX 0
+#define BLOCKER_POD_INDEX 1
+#define BLOCKER_TIME_SHARE 25 // Percentage of the turn given to the blocker search
+#define BLOCKER_TIME_SHARE_BEHIND 45 // When an opponent leads the race
+#define BLOCKER_TIME_SHARE_ENDGAME 10 // When the racer can solve the finish exactly
+#define BLOCKER_GUARD_DIVIDER 20 // Distance of the blocker to the next checkpoint of the opponent, per point of score
+#define BLOCKER_INTERCEPT_TURNS 3.0f
+
+// Allowed difference between the state received and the one predicted last turn to keep cached rollouts
+#define PREDICTION_POSITION_TOLERANCE 2.0f
+#define PREDICTION_SPEED_TOLERANCE 2.0f
+#define PREDICTION_ANGLE_TOLERANCE 1
+
+// Motion of each opponent fitted from its consecutive inputs, played by the opponent pods in the rollouts
+#define OPPONENT_MODEL_MINIMUM_OBSERVATIONS 3 // The opponents coast until their model has seen this many turns
+#define OPPONENT_MODEL_SMOOTHING 0.3f // Weight of the last observation in the running estimates
+#define OPPONENT_MODEL_CONTACT_MARGIN 200.0f // Turns where a pod may have touched another one are not fitted
+#define OPPONENT_MODEL_BOOST_THRUST 300.0f // Effective thrust only reachable with the boost
+#define OPPONENT_MODEL_SHIELD_THRUST 5.0f // A pod stopping its engine right after a contact is assumed to have shielded
+#define OPPONENT_MODEL_SHIELD_USUAL_THRUST 30.0f // Unless it rarely thrusts harder anyway
+#define OPPONENT_MODEL_SPEED_COMPENSATION -3.0f
+
+// Candidates can also be scored against other behaviours of the opponents, the first scenario is the opponent model.
+// The controlled pods keep the rollout of the first scenario until an opponent may touch them.
+#define SCENARIO_COUNT 1 // Up to OPPONENT_SCENARIO_COUNT
+#define SCENARIO_AGGREGATION SCENARIO_AGGREGATION_CVAR
+#define SCENARIO_CVAR_SHARE 50 // Percentage of the worst scenarios averaged by SCENARIO_AGGREGATION_CVAR
+
+// Scores of the genomes already evaluated this turn
+#define TRANSPOSITION_TABLE_SIZE 4096 // Power of two, small enough to stay in the L2 cache
+#define TRANSPOSITION_MAXIMUM_PROBES 8
+#define TRANSPOSITION_MOVE_BITS 15 // 6 bits of rotation, 7 bits of thrust, boost and shield
+#define TRANSPOSITION_MACRO_ACTION_BITS 25 // Checkpoint, 12 bits of aim offset, 7 bits of thrust, boost and 4 bits of turns
+
+// Genome of the racer, a few parameterised actions instead of one move per turn make longer horizons affordable
+#define GENOME GENOME_MOVES
+#define MACRO_ACTION_MAX_NB 4
+#define MACRO_ACTION_HORIZON NB_TURN_SIMULATED_MAX
+#define MACRO_ACTION_MAXIMUM_AIM_OFFSET 1500 // Beside the checkpoint, a checkpoint radius is 600
+#define MACRO_ACTION_AIM_NUDGE_SIZE 300
+#define MACRO_ACTION_PROBABILITY_TO_AIM_NEXT 25 // Aim at the checkpoint after the current one, to cut the turn
+
+// Candidates are abandoned mid-rollout when even a perfect end cannot beat the best score
+#define PRUNING_ROUNDING_SLACK 1.0f // Position rounding can move a pod a bit more than its speed each turn
+
+// Mutation operators are picked by a discounted UCB1 bandit rewarded by the candidates that improve the best score
+#define MUTATION_ROTATION_NUDGE_SIZE 6
+#define MUTATION_THRUST_NUDGE_SIZE 20
+#define MUTATION_BANDIT_DECAY 0.9995f // Older pulls weight less, so the bandit follows the situation
+#define MUTATION_BANDIT_EXPLORATION 0.05f
 
 #pragma region Game Rules
 
@@ -60,12 +184,54 @@ using namespace std::chrono;
 #define POD_BOOST_ACCELERATION 650
 #define POD_COLLISION_IMPULSE 120.0f
 #define POD_MASS_MULTIPLIER_BY_SHIELD 10
+#define POD_SHIELD_COOLDOWN 3 // Turns without thrust after a shield
 
 #define CHECKPOINT_MAX_NB 8
 #define CHECKPOINT_RADIUS 600.0f
 
 #pragma endregion 
 
+#pragma region Search Parameters
+
+// How the scores of the opponent scenarios of a candidate are combined
+enum ScenarioAggregation
+{
+	SCENARIO_AGGREGATION_MEAN,
+	SCENARIO_AGGREGATION_WORST,
+	SCENARIO_AGGREGATION_CVAR, // Mean of the worst scenarios
+};
+
+enum Genome
+{
+	GENOME_MOVES, // One move per turn
+	GENOME_MACRO_ACTIONS, // Moves of the racer expanded during the rollout from a few actions
+};
+
+// Runtime copy of the search constants so they can be tuned without recompiling
+struct SearchParameters
+{
+	int m_probabilityToUseBoost = PROBABILITY_TO_USE_BOOST;
+	int m_probabilityToFullThrottle = PROBABILITY_TO_FULL_THROTTLE;
+	int m_probabilityToNoThrottle = PROBABILITY_TO_NO_THROTTLE;
+	int m_evaluationCheckpointFactor = EVALUATION_CHECKPOINT_FACTOR;
+	int m_solutionsCount = SOLUTIONS_COUNT;
+	int m_nbTurnSimulated = NB_TURN_SIMULATED; // Never above NB_TURN_SIMULATED_MAX
+	int m_evaluationsPerTurn = EVALUATIONS_PER_TURN;
+	int m_timeAllocatedPerTurn = TIME_ALLOCATED_PER_TURN;
+	int m_heuristicSeedsCount = HEURISTIC_SEEDS_COUNT;
+	int m_probabilityToAppendHeuristic = PROBABILITY_TO_APPEND_HEURISTIC;
+	int m_mapAnalysisTime = MAP_ANALYSIS_TIME;
+	bool m_isHorizonAdaptive = true; // Always m_nbTurnSimulated otherwise, so the scores of different searches compare
+	int m_scenarioCount = SCENARIO_COUNT;
+	int m_scenarioAggregation = SCENARIO_AGGREGATION;
+	int m_simulationBudget = SIMULATION_BUDGET; // The same state then always gives the same moves, whatever the machine
+	unsigned int m_seed = DETERMINISTIC_SEED;
+	int m_genome = GENOME; // The blocker always searches moves
+	int m_macroActionHorizon = MACRO_ACTION_HORIZON;
+};
+
+#pragma endregion
+
 #pragma region Random Class
 
 class Random
@@ -73,10 +239,14 @@ class Random
 public:
 
 	inline static int Range(int _minimumValue, int _maximumValue);
+	inline static void SetSeed(unsigned int _seed) { m_seed = _seed; }
 
 private:
 
 	inline static int GenerateNumber();
+
+	// One generator per thread so in-process games can run in parallel
+	inline static thread_local unsigned int m_seed = 0;
 };
 
 inline int Random::Range(int _minimumValue, int _maximumValue)
@@ -86,7 +256,6 @@ inline int Random::Range(int _minimumValue, int _maximumValue)
 
 inline int Random::GenerateNumber()
 {
-	static unsigned int m_seed;
 	m_seed = (214013 * m_seed + 2531011);
 	return (m_seed >> 16) & 0x7FFF;
 }
@@ -270,6 +439,97 @@ ostream& operator<<(ostream& _output, const Vector2& _v)
 
 #pragma endregion
 
+#pragma region Input and Output Structures
+
+struct PodInput
+{
+	int m_x = 0;
+	int m_y = 0;
+	int m_speedX = 0;
+	int m_speedY = 0;
+	int m_angle = 0;
+	int m_nextCheckpointIndex = 0;
+};
+
+struct PodOutput
+{
+	Vector2 m_target;
+	int m_thrust = 0;
+	bool m_useBoost = false;
+	bool m_useShield = false;
+	string m_hoverText = "";
+};
+
+// Given once before the first turn
+struct MapInput
+{
+	int m_numberOfLaps = 0;
+	vector<Vector2> m_checkpoints;
+};
+
+struct TurnInput
+{
+	array<PodInput, POD_TOTAL_NB> m_pods; // Controlled pods first
+};
+
+#pragma endregion
+
+#pragma region Stream Adapter
+
+// Only main and the watchdog talk to the referee streams, everything else works on the structures above
+MapInput ReadMapInput(istream& _stream)
+{
+	MapInput mapInput;
+	int checkpointCount = 0;
+	_stream >> mapInput.m_numberOfLaps;
+	_stream.ignore();
+	_stream >> checkpointCount;
+	_stream.ignore();
+
+	mapInput.m_checkpoints.resize(checkpointCount);
+	for (int iCheckpoint = 0; iCheckpoint < checkpointCount; iCheckpoint++)
+	{
+		_stream >> mapInput.m_checkpoints[iCheckpoint].m_x >> mapInput.m_checkpoints[iCheckpoint].m_y;
+		_stream.ignore();
+	}
+	return mapInput;
+}
+
+TurnInput ReadTurnInput(istream& _stream)
+{
+	TurnInput turnInput;
+	for (size_t iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		PodInput& input = turnInput.m_pods[iPod];
+		_stream >> input.m_x >> input.m_y >> input.m_speedX >> input.m_speedY >> input.m_angle >> input.m_nextCheckpointIndex;
+		_stream.ignore();
+	}
+	return turnInput;
+}
+
+void WriteOutputs(ostream& _stream, const array<PodOutput, POD_CONTROLLABLE_NB>& _outputs)
+{
+	for (size_t iPod = 0; iPod < POD_CONTROLLABLE_NB; iPod++)
+	{
+		const PodOutput& output = _outputs[iPod];
+
+		if (output.m_useBoost)
+		{
+			_stream << output.m_target << " " << BOOST_KEYWORD << output.m_hoverText << endl;
+		}
+		else if (output.m_useShield)
+		{
+			_stream << output.m_target << " " << SHIELD_KEYWORD << output.m_hoverText << endl;
+		}
+		else
+		{
+			_stream << output.m_target << " " << output.m_thrust << output.m_hoverText << endl;
+		}
+	}
+}
+
+#pragma endregion
+
 #pragma region Entity Class
 
 class Entity
@@ -292,18 +552,8 @@ public:
 
 class Checkpoint : public Entity
 {
-public:
-
-	void ReceiveInput(int _index);
 };
 
-void Checkpoint::ReceiveInput(int _index)
-{
-	m_index = _index;
-	cin >> m_position.m_x >> m_position.m_y;
-	cin.ignore();
-}
-
 #pragma endregion
 
 #pragma region Pod Class
@@ -314,12 +564,16 @@ public:
 
 	static void Bounce(Pod* _pod1, Pod* _pod2);
 
-	void ReceiveInput(int _index);
+	void ApplyInput(int _index, const PodInput& _input);
 	int GetMass();
+	float ComputeReach(int _nbTurn, bool _canBoost) const;
+	bool CanBoost() const { return false == m_usedBoost && (m_boostCheckpointIndex < 0 || m_currentCheckpointIndex == m_boostCheckpointIndex); }
 
 	// Pod values
 	bool m_usedBoost = false;
+	int m_boostCheckpointIndex = -1; // Checkpoint the boost is kept for, any checkpoint when negative
 	bool m_isUsingShield = false;
+	int m_shieldCooldown = 0; // Turns left without thrust
 	int m_angle = 0.0f; // Obtained from input
 	int m_mass = 1;
 
@@ -346,20 +600,19 @@ void Pod::Bounce(Pod* _pod1, Pod* _pod2)
 	_pod2->m_speed += reboundDirection * (-1.0f / massPod2) * impulseToUse;
 }
 
-void Pod::ReceiveInput(int _index)
+void Pod::ApplyInput(int _index, const PodInput& _input)
 {
-	int newCheckpointIndex = 0;
-
-	cin >> m_position.m_x >> m_position.m_y >> m_speed.m_x >> m_speed.m_y >> m_angle >> newCheckpointIndex;
-	cin.ignore();
+	m_position = Vector2((float)_input.m_x, (float)_input.m_y);
+	m_speed = Vector2((float)_input.m_speedX, (float)_input.m_speedY);
+	m_angle = _input.m_angle;
 
 	m_index = _index;
 
-	if (newCheckpointIndex != m_currentCheckpointIndex)
+	if (_input.m_nextCheckpointIndex != m_currentCheckpointIndex)
 	{
-		cerr << "Pod " << m_index << " Checkpoint passed" << endl;
+		DEBUG_LOG << "Pod " << m_index << " Checkpoint passed" << endl;
 		m_checkpointPassedCount++;
-		m_currentCheckpointIndex = newCheckpointIndex;
+		m_currentCheckpointIndex = _input.m_nextCheckpointIndex;
 	}
 }
 
@@ -369,6 +622,20 @@ int Pod::GetMass()
 	return 1;
 }
 
+// Longest distance the pod can travel in the given turns on its engine, boosting as soon as possible
+float Pod::ComputeReach(int _nbTurn, bool _canBoost) const
+{
+	float speed = m_speed.Magnitude();
+	float reach = 0.0f;
+	for (int iTurn = 0; iTurn < _nbTurn; iTurn++)
+	{
+		speed += (iTurn == 0 && _canBoost) ? POD_BOOST_ACCELERATION : POD_MAX_THRUST;
+		reach += speed + PRUNING_ROUNDING_SLACK;
+		speed *= POD_FRICTION;
+	}
+	return reach;
+}
+
 #pragma endregion
 
 #pragma region Solution Class and members stuctures
@@ -379,6 +646,9 @@ struct Move
 	int m_thrust = 0; // From 0 to 100
 	bool m_useBoost = false;
 	bool m_useShield = false;
+
+	inline bool operator== (const Move& _move) const { return m_rotation == _move.m_rotation && m_thrust == _move.m_thrust && m_useBoost == _move.m_useBoost && m_useShield == _move.m_useShield; };
+	inline bool operator!= (const Move& _move) const { return false == (*this == _move); };
 };
 
 struct Turn
@@ -386,38 +656,132 @@ struct Turn
 	array<Move, POD_NB_TO_SIMULATE> m_moves;
 };
 
+// Steers for a few turns, the moves are computed from the state reached on each of them
+struct MacroAction
+{
+	int m_checkpointOffset = 0; // 0 aims at the current checkpoint of the pod, 1 at the one after
+	int m_aimOffset = 0; // Beside the checkpoint, along the normal of the line from the pod
+	int m_thrust = POD_MAX_THRUST;
+	bool m_useBoost = false; // On the first turn of the action
+	int m_nbTurn = 1;
+};
+
 class Solution
 {
 public:
 
-	static Move GenerateMove(const Pod& _pod);
+	static Move GenerateMove(const Pod& _pod, const SearchParameters& _parameters);
 
-	void ShiftTurn(const array<Pod, POD_TOTAL_NB>& _pods);
+	int ShiftTurn(const array<Pod, POD_TOTAL_NB>& _pods, const SearchParameters& _parameters, int _nbTurnSimulated);
+	void GenerateMacroActions(const Pod& _pod, const SearchParameters& _parameters, int _nbTurnSimulated);
+	void FitMacroActions(int _nbTurnSimulated); // The last action is stretched or cut to end with the horizon
+	int FindMacroAction(int _turn, int* _firstTurn) const;
 
 	int m_score = -1;
-	array<Turn, NB_TURN_SIMULATED> m_turns;
+	array<Turn, NB_TURN_SIMULATED_MAX> m_turns;
+
+	// Pods at the end of each simulated turn, so a rollout can restart from any turn
+	array<array<Pod, POD_TOTAL_NB>, NB_TURN_SIMULATED_MAX> m_snapshots;
+	int m_firstCollisionTurn = NB_TURN_SIMULATED_MAX; // First turn where pods bounced in the last rollout
+	int m_nbTurnSimulated = 0; // Horizon of the last rollout
+
+	// Genome of the searched pod when there are actions, its moves are then only the expansion of the last rollout
+	array<MacroAction, MACRO_ACTION_MAX_NB> m_macroActions;
+	int m_nbMacroAction = 0;
 
 private:
 };
 
-void Solution::ShiftTurn(const array<Pod, POD_TOTAL_NB>& _pods)
+// Returns the number of turns that were kept, the following ones up to the new horizon are random
+int Solution::ShiftTurn(const array<Pod, POD_TOTAL_NB>& _pods, const SearchParameters& _parameters, int _nbTurnSimulated)
 {
-	for (int iTurn = 1; iTurn < NB_TURN_SIMULATED; iTurn++)
+	const int nbTurnKept = max(m_nbTurnSimulated - 1, 0);
+
+	for (int iTurn = 1; iTurn < m_nbTurnSimulated; iTurn++)
 	{
 		for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
 		{
 			m_turns[iTurn - 1] = m_turns[iTurn];
 		}
+		m_snapshots[iTurn - 1] = m_snapshots[iTurn];
 	}
+	if (m_firstCollisionTurn < NB_TURN_SIMULATED_MAX) m_firstCollisionTurn = max(m_firstCollisionTurn - 1, 0); // A bounce on the dropped turn forces a full rollout
 
-	//create a new random turn
-	for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+	//create new random turns
+	for (int iTurn = nbTurnKept; iTurn < _nbTurnSimulated; iTurn++)
+	{
+		for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+		{
+			m_turns[iTurn].m_moves[iPod] = GenerateMove(_pods[iPod], _parameters);
+		}
+	}
+
+	// The turn played is removed from the first action, the last one covers the new turns
+	if (m_nbMacroAction > 0 && --m_macroActions[0].m_nbTurn <= 0)
+	{
+		for (int iAction = 1; iAction < m_nbMacroAction; iAction++) m_macroActions[iAction - 1] = m_macroActions[iAction];
+		m_nbMacroAction--;
+	}
+	else if (m_nbMacroAction > 0) m_macroActions[0].m_useBoost = false;
+	FitMacroActions(_nbTurnSimulated);
+
+	return nbTurnKept;
+}
+
+void Solution::GenerateMacroActions(const Pod& _pod, const SearchParameters& _parameters, int _nbTurnSimulated)
+{
+	m_nbMacroAction = Random::Range(1, min(MACRO_ACTION_MAX_NB, _nbTurnSimulated) + 1);
+	int nbTurnLeft = _nbTurnSimulated;
+	for (int iAction = 0; iAction < m_nbMacroAction; iAction++)
+	{
+		MacroAction& action = m_macroActions[iAction];
+		int nbActionLeft = m_nbMacroAction - iAction - 1;
+		action.m_nbTurn = nbActionLeft == 0 ? nbTurnLeft : Random::Range(1, nbTurnLeft - nbActionLeft + 1);
+		nbTurnLeft -= action.m_nbTurn;
+
+		action.m_checkpointOffset = Random::Range(0, 100) < MACRO_ACTION_PROBABILITY_TO_AIM_NEXT ? 1 : 0;
+		action.m_aimOffset = Random::Range(-MACRO_ACTION_MAXIMUM_AIM_OFFSET, MACRO_ACTION_MAXIMUM_AIM_OFFSET + 1);
+		action.m_useBoost = iAction == 0 && _pod.CanBoost() && Random::Range(0, 100) < _parameters.m_probabilityToUseBoost;
+		action.m_thrust = Random::Range(0, 100) < _parameters.m_probabilityToFullThrottle ? POD_MAX_THRUST : Random::Range(0, POD_MAX_THRUST + 1);
+	}
+}
+
+void Solution::FitMacroActions(int _nbTurnSimulated)
+{
+	if (m_nbMacroAction == 0) return;
+
+	int nbTurn = 0;
+	for (int iAction = 0; iAction < m_nbMacroAction; iAction++)
+	{
+		MacroAction& action = m_macroActions[iAction];
+		if (nbTurn + action.m_nbTurn >= _nbTurnSimulated || iAction == m_nbMacroAction - 1)
+		{
+			action.m_nbTurn = max(_nbTurnSimulated - nbTurn, 1);
+			m_nbMacroAction = iAction + 1;
+			return;
+		}
+		nbTurn += action.m_nbTurn;
+	}
+}
+
+// Index of the action played on the given turn, the last one past the horizon
+int Solution::FindMacroAction(int _turn, int* _firstTurn) const
+{
+	int firstTurn = 0;
+	for (int iAction = 0; iAction < m_nbMacroAction - 1; iAction++)
 	{
-		m_turns[NB_TURN_SIMULATED - 1].m_moves[iPod] = GenerateMove(_pods[iPod]);
+		if (_turn < firstTurn + m_macroActions[iAction].m_nbTurn)
+		{
+			*_firstTurn = firstTurn;
+			return iAction;
+		}
+		firstTurn += m_macroActions[iAction].m_nbTurn;
 	}
+	*_firstTurn = firstTurn;
+	return m_nbMacroAction - 1;
 }
 
-Move Solution::GenerateMove(const Pod& _pod)
+Move Solution::GenerateMove(const Pod& _pod, const SearchParameters& _parameters)
 {
 	Move move;
 
@@ -429,15 +793,15 @@ Move Solution::GenerateMove(const Pod& _pod)
 	move.m_rotation = Random::Range(minimumRotation, maximumRotation);
 
 	// Shield
-	/*move.m_useShield = (false == move.m_useShield) && (Random::Range(0, 100) < PROBABILITY_TO_USE_SHIELD);
+	move.m_useShield = _pod.m_index == BLOCKER_POD_INDEX && (Random::Range(0, 100) < PROBABILITY_TO_USE_SHIELD);
 	if (move.m_useShield)
 	{
 		move.m_thrust = 0;
 		return move;
-	}*/
+	}
 
 	// Boost
-	move.m_useBoost = (false == _pod.m_usedBoost) && (Random::Range(0, 100) < PROBABILITY_TO_USE_BOOST);
+	move.m_useBoost = _pod.CanBoost() && (Random::Range(0, 100) < _parameters.m_probabilityToUseBoost);
 	if (move.m_useBoost)
 	{
 		move.m_thrust = 0;
@@ -446,8 +810,8 @@ Move Solution::GenerateMove(const Pod& _pod)
 
 	// Thrust
 	int random = Random::Range(0, 100);
-	if (random < PROBABILITY_TO_FULL_THROTTLE) { move.m_thrust = 100; }
-	else if (random < PROBABILITY_TO_NO_THROTTLE) { move.m_thrust = 10; }
+	if (random < _parameters.m_probabilityToFullThrottle) { move.m_thrust = 100; }
+	else if (random < _parameters.m_probabilityToNoThrottle) { move.m_thrust = 10; }
 	else
 	{
 		int minimumThrust = move.m_thrust - (int)(THRUST_CHANGE_BY_MUTATION);
@@ -469,16 +833,170 @@ bool CompareByScore(const Solution& a, const Solution& b)
 
 #pragma endregion
 
+#pragma region Known Maps
+
+// Racing lines and boost checkpoints of the arena layouts, optimized offline by Tools/RacingLineOptimizer.cpp
+struct KnownMap
+{
+	int m_checkpointCount;
+	int m_checkpoints[CHECKPOINT_MAX_NB][2];
+	int m_racingLineOffsets[CHECKPOINT_MAX_NB][2]; // From the center of each checkpoint
+	int m_boostCheckpointIndexes[CHECKPOINT_MAX_NB]; // For each starting checkpoint, negative when the boost is not kept for one
+};
+
+#if defined(__has_include)
+#if __has_include("GoldRacingLines.h")
+#include "GoldRacingLines.h"
+#define HAS_KNOWN_MAPS
+#endif
+#endif
+#ifndef HAS_KNOWN_MAPS
+#define KNOWN_MAP_COUNT 0
+constexpr KnownMap KNOWN_MAPS[1] = {};
+#endif
+
+#pragma endregion
+
+#pragma region Opponent Model Class
+
+// Heading targets an opponent may steer to, the one explaining its rotations best is kept
+enum OpponentTarget
+{
+	OPPONENT_TARGET_CHECKPOINT,
+	OPPONENT_TARGET_COMPENSATED, // Checkpoint minus a few turns of speed
+	OPPONENT_TARGET_COUNT
+};
+
+// Behaviours the opponents are simulated with, the first one is the default of every rollout
+enum OpponentScenario
+{
+	OPPONENT_SCENARIO_MODEL, // Predicted move, coasting until the model is reliable
+	OPPONENT_SCENARIO_BLOCK, // The opponent behind goes to meet the racer
+	OPPONENT_SCENARIO_FULL_THRUST,
+	OPPONENT_SCENARIO_COAST,
+	OPPONENT_SCENARIO_COUNT
+};
+
+// Effective thrust and heading target of one opponent pod, updated in constant time every turn
+class OpponentModel
+{
+public:
+
+	void Observe(const Pod& _previousPod, const Pod& _pod, const Vector2& _checkpointPosition, bool _isInContact);
+	Move PredictMove(const Pod& _pod, const Vector2& _checkpointPosition) const;
+	static Move PredictBlockingMove(const Pod& _pod, const Pod& _target); // Full thrust to meet the target pod
+	bool IsReliable() const { return m_nbObservation >= OPPONENT_MODEL_MINIMUM_OBSERVATIONS; }
+	bool HasUsedBoost() const { return m_hasUsedBoost; }
+	int GetShieldCooldown() const { return m_shieldCooldown; }
+
+private:
+
+	static int ComputeRotation(const Pod& _pod, const Vector2& _target);
+	static Vector2 ComputeTarget(OpponentTarget _target, const Pod& _pod, const Vector2& _checkpointPosition);
+
+	float m_thrust = POD_MAX_THRUST;
+	float m_targetErrors[OPPONENT_TARGET_COUNT] = {}; // Smoothed rotation error of each heading target, in degrees
+	int m_nbObservation = 0;
+	bool m_hasUsedBoost = false;
+	bool m_wasInContact = false;
+	int m_shieldCooldown = 0; // Turns left without thrust
+};
+
+void OpponentModel::Observe(const Pod& _previousPod, const Pod& _pod, const Vector2& _checkpointPosition, bool _isInContact)
+{
+	// The rotation is chosen before any contact, every target is scored against the one received
+	int rotation = (_pod.m_angle - _previousPod.m_angle + 540) % 360 - 180;
+	for (int iTarget = 0; iTarget < OPPONENT_TARGET_COUNT; iTarget++)
+	{
+		Vector2 target = ComputeTarget((OpponentTarget)iTarget, _previousPod, _checkpointPosition);
+		float error = (float)abs(ComputeRotation(_previousPod, target) - rotation);
+		m_targetErrors[iTarget] += (error - m_targetErrors[iTarget]) * OPPONENT_MODEL_SMOOTHING;
+	}
+	m_nbObservation++;
+
+	bool wasInContact = m_wasInContact;
+	m_wasInContact = _isInContact;
+	if (m_shieldCooldown > 0) m_shieldCooldown--;
+	if (_isInContact || m_shieldCooldown > 0) return;
+
+	// Speed before the friction and the truncation, minus the speed of last turn, projected on the new heading
+	Vector2 acceleration = _pod.m_speed * (1.0f / POD_FRICTION) - _previousPod.m_speed;
+	float angleRad = DEG_TO_RAD(_pod.m_angle);
+	float thrust = Vector2::Dot(acceleration, Vector2(cos(angleRad), sin(angleRad)));
+	if (thrust > OPPONENT_MODEL_BOOST_THRUST)
+	{
+		m_hasUsedBoost = true;
+		return;
+	}
+	if (wasInContact && thrust < OPPONENT_MODEL_SHIELD_THRUST && m_thrust > OPPONENT_MODEL_SHIELD_USUAL_THRUST)
+	{
+		m_shieldCooldown = POD_SHIELD_COOLDOWN - 1;
+		return;
+	}
+	m_thrust += (clamp(thrust, 0.0f, (float)POD_MAX_THRUST) - m_thrust) * OPPONENT_MODEL_SMOOTHING;
+}
+
+Move OpponentModel::PredictMove(const Pod& _pod, const Vector2& _checkpointPosition) const
+{
+	int bestTarget = 0;
+	for (int iTarget = 1; iTarget < OPPONENT_TARGET_COUNT; iTarget++)
+	{
+		if (m_targetErrors[iTarget] < m_targetErrors[bestTarget]) bestTarget = iTarget;
+	}
+
+	Move move;
+	move.m_rotation = ComputeRotation(_pod, ComputeTarget((OpponentTarget)bestTarget, _pod, _checkpointPosition));
+	move.m_thrust = (int)round(m_thrust);
+	return move;
+}
+
+Move OpponentModel::PredictBlockingMove(const Pod& _pod, const Pod& _target)
+{
+	Move move;
+	move.m_rotation = ComputeRotation(_pod, _target.m_position + _target.m_speed * BLOCKER_INTERCEPT_TURNS);
+	move.m_thrust = POD_MAX_THRUST;
+	return move;
+}
+
+int OpponentModel::ComputeRotation(const Pod& _pod, const Vector2& _target)
+{
+	Vector2 podToTarget = _target - _pod.m_position;
+	float targetAngle = RAD_TO_DEG(atan2(podToTarget.m_y, podToTarget.m_x));
+	float rotation = fmod(targetAngle - _pod.m_angle + 540.0f, 360.0f) - 180.0f;
+	return (int)round(clamp(rotation, -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION));
+}
+
+Vector2 OpponentModel::ComputeTarget(OpponentTarget _target, const Pod& _pod, const Vector2& _checkpointPosition)
+{
+	if (_target == OPPONENT_TARGET_COMPENSATED) return _checkpointPosition + _pod.m_speed * OPPONENT_MODEL_SPEED_COMPENSATION;
+	return _checkpointPosition;
+}
+
+#pragma endregion
+
 #pragma region Simulation Class
 
 class Simulation
 {
 public:
 
-	void InitializeCheckpoints();
-	void ReceivePodsInputs(bool _isFirstTurn = false);
-	void SimulateSolution(const Solution& _solution);
-	void SendOutputFromSolution(const Solution& _solution);
+	void InitializeCheckpoints(int _numberOfLaps, const vector<Vector2>& _checkpointPositions);
+	void ApplyPodsInputs(const array<PodInput, POD_TOTAL_NB>& _inputs, bool _isFirstTurn = false);
+	void SimulateSolution(Solution& _solution, int _nbTurnSimulated, int _firstTurn = 0);
+	void ContinueSolution(Solution& _solution); // Simulate one more turn of the last rollout of this solution
+	void SimulateTurn(const array<Move, POD_NB_TO_SIMULATE>& _moves);
+	void SimulateScenario(const Solution& _solution, int _scenario); // Ends with the last turn of the scenario in m_tempPods
+	long long GetSimulatedTurnCount() const { return m_nbSimulatedTurn; }
+	bool HasCollided() const { return m_hasCollided; } // During the last simulated turn
+	void SetPrediction(const Solution& _solution);
+	bool MatchesPrediction() const;
+	void LoadPrediction() { m_pods = m_predictedPods; m_turn++; ResetProximity(); }
+	void AnalyseProximity(int _nbTurnSimulated); // Until new pods are set, valid for rollouts of that many turns from m_pods
+	array<PodOutput, POD_CONTROLLABLE_NB> ComputeOutputsFromSolution(const Solution& _solution) const;
+	array<PodOutput, POD_CONTROLLABLE_NB> ComputeOutputsFromMoves(const array<Move, POD_NB_TO_SIMULATE>& _moves) const;
+	void ApplyOutputs(const array<PodOutput, POD_CONTROLLABLE_NB>& _outputs); // Keep track of what was sent, like the boost
+	int FindEnemyLeader(const array<Pod, POD_TOTAL_NB>& _pods) const;
+	const OpponentModel& GetOpponentModel(int _podIndex) const { return m_opponentModels[_podIndex - POD_CONTROLLABLE_NB]; }
 
 	array<Pod, POD_TOTAL_NB> m_pods; // Pods currenly in game
 	Checkpoint m_checkpoints[CHECKPOINT_MAX_NB];
@@ -486,35 +1004,103 @@ public:
 	int m_checkpointCount_Lap = 0; // Checkpoints in one lap
 	int m_checkpointCount_Race = 0; // Checkpoints in the race
 	array<Pod, POD_TOTAL_NB> m_tempPods; // Temporary pods created for the current simulation
+	int m_turn = 0; // Turns played since the start of the race
+
+	// Where the best lap of the map analysis crossed each checkpoint
+	array<Vector2, CHECKPOINT_MAX_NB> m_racingLine;
+	bool m_hasRacingLine = false;
+	int m_knownMapIndex = -1; // Index in KNOWN_MAPS, negative when the layout is new
+	int m_knownBoostCheckpointIndex = -1; // Boost checkpoint of the known map from this start
+
+	bool m_useOpponentModels = true; // The opponents coast when disabled
 
 private:
 
+	array<OpponentModel, POD_TOTAL_NB - POD_CONTROLLABLE_NB> m_opponentModels;
+	int m_opponentScenario = OPPONENT_SCENARIO_MODEL;
+
+	array<Pod, POD_TOTAL_NB> m_predictedPods; // Pods expected next turn if the chosen solution goes as planned
+	bool m_hasPrediction = false;
+	bool m_hasCollided = false;
+	long long m_nbSimulatedTurn = 0;
+
+	// Pods that cannot touch any other one during the rollouts, their pairs are not checked for collisions
+	array<bool, POD_TOTAL_NB> m_isPodIsolated = {};
+	bool m_areAllPodsIsolated = false;
+
 	void SimulateBeforePhysics(const array<Move, POD_NB_TO_SIMULATE> _moves);
-	void SimulatePhysics();
-	void SimulateAfterPhysics();
+	void SimulateOpponents();
+	void SimulatePhysics(int _firstPodIndex = 0);
+	void SimulateAfterPhysics(int _firstPodIndex = 0);
+	void MovePod(Pod* _pod, float _deltaTime);
+	void ResetProximity() { m_isPodIsolated = {}; m_areAllPodsIsolated = false; } // Every pair is checked again
+	bool CanOpponentsTouch(const array<Pod, POD_TOTAL_NB>& _pods, const array<Pod, POD_TOTAL_NB>& _snapshot) const;
+	void FindKnownMap();
+	void UpdateOpponentModels(const array<Pod, POD_TOTAL_NB>& _previousPods);
 };
 
-void Simulation::InitializeCheckpoints()
+void Simulation::InitializeCheckpoints(int _numberOfLaps, const vector<Vector2>& _checkpointPositions)
 {
-	cin >> m_numberOfLaps;
-	cin.ignore();
-	cin >> m_checkpointCount_Lap;
-	cin.ignore();
-	for (size_t iCheckpoint = 0; iCheckpoint < m_checkpointCount_Lap; iCheckpoint++)
+	m_numberOfLaps = _numberOfLaps;
+	m_checkpointCount_Lap = (int)_checkpointPositions.size();
+	for (int iCheckpoint = 0; iCheckpoint < m_checkpointCount_Lap; iCheckpoint++)
 	{
-		m_checkpoints[iCheckpoint].ReceiveInput(iCheckpoint);
+		m_checkpoints[iCheckpoint].m_index = iCheckpoint;
+		m_checkpoints[iCheckpoint].m_position = _checkpointPositions[iCheckpoint];
 	}
 	m_checkpointCount_Race = m_checkpointCount_Lap * m_numberOfLaps;
-	cerr << "Checkpoints Initialized" << endl;
+	FindKnownMap();
+	DEBUG_LOG << "Checkpoints Initialized" << endl;
+}
+
+// The racing line of a known layout is used right away, relative to the checkpoints actually received
+void Simulation::FindKnownMap()
+{
+	m_knownMapIndex = -1;
+	m_knownBoostCheckpointIndex = -1;
+	m_hasRacingLine = false;
+	for (int iMap = 0; iMap < KNOWN_MAP_COUNT; iMap++)
+	{
+		const KnownMap& knownMap = KNOWN_MAPS[iMap];
+		if (knownMap.m_checkpointCount != m_checkpointCount_Lap) continue;
+
+		for (int iRotation = 0; iRotation < m_checkpointCount_Lap; iRotation++)
+		{
+			bool isMatching = true;
+			for (int iCheckpoint = 0; iCheckpoint < m_checkpointCount_Lap && isMatching; iCheckpoint++)
+			{
+				const int* knownPosition = knownMap.m_checkpoints[(iCheckpoint + iRotation) % m_checkpointCount_Lap];
+				const Vector2& position = m_checkpoints[iCheckpoint].m_position;
+				isMatching = fabs(position.m_x - knownPosition[0]) <= KNOWN_MAP_TOLERANCE && fabs(position.m_y - knownPosition[1]) <= KNOWN_MAP_TOLERANCE;
+			}
+			if (false == isMatching) continue;
+
+			for (int iCheckpoint = 0; iCheckpoint < m_checkpointCount_Lap; iCheckpoint++)
+			{
+				const int* offset = knownMap.m_racingLineOffsets[(iCheckpoint + iRotation) % m_checkpointCount_Lap];
+				m_racingLine[iCheckpoint] = m_checkpoints[iCheckpoint].m_position + Vector2((float)offset[0], (float)offset[1]);
+			}
+			m_hasRacingLine = true;
+			m_knownMapIndex = iMap;
+
+			// The race starts from the checkpoint of the layout that was received first
+			const int boostCheckpointIndex = knownMap.m_boostCheckpointIndexes[iRotation];
+			m_knownBoostCheckpointIndex = boostCheckpointIndex < 0 ? -1 : (boostCheckpointIndex - iRotation + m_checkpointCount_Lap) % m_checkpointCount_Lap;
+			DEBUG_LOG << "Known map " << iMap << " with a rotation of " << iRotation << endl;
+			return;
+		}
+	}
 }
 
-void Simulation::ReceivePodsInputs(bool _isFirstTurn)
+void Simulation::ApplyPodsInputs(const array<PodInput, POD_TOTAL_NB>& _inputs, bool _isFirstTurn)
 {
+	m_turn = _isFirstTurn ? 0 : m_turn + 1;
+	array<Pod, POD_TOTAL_NB> previousPods = m_pods;
 	for (size_t iPod = 0; iPod < POD_TOTAL_NB; iPod++)
 	{
 		Pod& pod = m_pods[iPod];
 
-		pod.ReceiveInput(iPod);
+		pod.ApplyInput(iPod, _inputs[iPod]);
 
 		if (false == _isFirstTurn) continue;
 
@@ -525,17 +1111,72 @@ void Simulation::ReceivePodsInputs(bool _isFirstTurn)
 		pod.m_angle = newAngle;
 	}
 
-	///cerr << "Received inputs" << endl;
+	if (_isFirstTurn) m_opponentModels = {};
+	else UpdateOpponentModels(previousPods);
+	ResetProximity();
+}
+
+// Until a first bounce the pods only move on their engines, so a pod further from all the others than their reaches cannot touch them.
+// A pod that bounces anyway has met a pod that was not isolated, and is checked against every other one from then on.
+void Simulation::AnalyseProximity(int _nbTurnSimulated)
+{
+	array<float, POD_TOTAL_NB> reaches;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		// The opponents never boost in the rollouts
+		const Pod& pod = m_pods[iPod];
+		reaches[iPod] = pod.ComputeReach(_nbTurnSimulated, iPod < POD_NB_TO_SIMULATE && false == pod.m_usedBoost);
+	}
+
+	m_isPodIsolated.fill(true);
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		for (int iOtherPod = iPod + 1; iOtherPod < POD_TOTAL_NB; iOtherPod++)
+		{
+			float contactDistance = reaches[iPod] + reaches[iOtherPod] + POD_COLLIDER_SIZE + POD_COLLIDER_SIZE;
+			if (Vector2::SquareDistance(m_pods[iPod].m_position, m_pods[iOtherPod].m_position) >= contactDistance * contactDistance) continue;
+			m_isPodIsolated[iPod] = false;
+			m_isPodIsolated[iOtherPod] = false;
+		}
+	}
+	m_areAllPodsIsolated = all_of(m_isPodIsolated.begin(), m_isPodIsolated.end(), [](bool _isIsolated) { return _isIsolated; });
+}
+
+// Consecutive inputs of each opponent are fitted, unless it may have touched another pod during the turn
+void Simulation::UpdateOpponentModels(const array<Pod, POD_TOTAL_NB>& _previousPods)
+{
+	for (int iPod = POD_CONTROLLABLE_NB; iPod < POD_TOTAL_NB; iPod++)
+	{
+		const Pod& previousPod = _previousPods[iPod];
+		bool isInContact = false;
+		for (int iOtherPod = 0; iOtherPod < POD_TOTAL_NB && false == isInContact; iOtherPod++)
+		{
+			if (iOtherPod == iPod) continue;
+			const Pod& otherPod = _previousPods[iOtherPod];
+			float contactDistance = POD_COLLIDER_SIZE * 2.0f + (previousPod.m_speed - otherPod.m_speed).Magnitude() + OPPONENT_MODEL_CONTACT_MARGIN;
+			isInContact = Vector2::SquareDistance(previousPod.m_position, otherPod.m_position) < contactDistance * contactDistance;
+		}
+
+		OpponentModel& model = m_opponentModels[iPod - POD_CONTROLLABLE_NB];
+		model.Observe(previousPod, m_pods[iPod], m_checkpoints[previousPod.m_currentCheckpointIndex].m_position, isInContact);
+
+		Pod& pod = m_pods[iPod];
+		if (model.HasUsedBoost()) pod.m_usedBoost = true;
+		pod.m_shieldCooldown = model.GetShieldCooldown();
+	}
 }
 
-void Simulation::SimulateSolution(const Solution& _solution)
+void Simulation::SimulateSolution(Solution& _solution, int _nbTurnSimulated, int _firstTurn)
 {
-	m_tempPods = m_pods; // Copy the initial pods for the new solution
-	for (int iTurn = 0; iTurn < NB_TURN_SIMULATED; iTurn++)
+	// Copy the initial pods for the new solution, or restart from the turn before the first one to simulate
+	if (_firstTurn > 0) m_tempPods = _solution.m_snapshots[_firstTurn - 1];
+	else m_tempPods = m_pods;
+
+	if (_firstTurn == 0 || _solution.m_firstCollisionTurn >= _firstTurn) _solution.m_firstCollisionTurn = NB_TURN_SIMULATED_MAX;
+	_solution.m_nbTurnSimulated = _firstTurn;
+	for (int iTurn = _firstTurn; iTurn < _nbTurnSimulated; iTurn++)
 	{
-		SimulateBeforePhysics(_solution.m_turns[iTurn].m_moves);
-		SimulatePhysics();
-		SimulateAfterPhysics();
+		ContinueSolution(_solution);
 	}
 	///for (int iPod = 0; iPod < NB_SIMULATED_POD; iPod++)
 	///{
@@ -543,42 +1184,155 @@ void Simulation::SimulateSolution(const Solution& _solution)
 	///}
 }
 
-void Simulation::SendOutputFromSolution(const Solution& _solution)
+void Simulation::ContinueSolution(Solution& _solution)
+{
+	int turn = _solution.m_nbTurnSimulated;
+	SimulateTurn(_solution.m_turns[turn].m_moves);
+	_solution.m_snapshots[turn] = m_tempPods;
+	if (m_hasCollided && turn < _solution.m_firstCollisionTurn) _solution.m_firstCollisionTurn = turn;
+	_solution.m_nbTurnSimulated = turn + 1;
+}
+
+void Simulation::SimulateTurn(const array<Move, POD_NB_TO_SIMULATE>& _moves)
+{
+	m_hasCollided = false;
+	m_nbSimulatedTurn++;
+	SimulateOpponents(); // First, they do not know the moves of this turn
+	SimulateBeforePhysics(_moves);
+	SimulatePhysics();
+	SimulateAfterPhysics();
+}
+
+// Only the opponents are simulated while they cannot touch the controlled pods, which take the snapshots of the rollout.
+// The rollout must be up to date, and the controlled pods are simulated again from the first turn they could be touched.
+void Simulation::SimulateScenario(const Solution& _solution, int _scenario)
+{
+	m_opponentScenario = _scenario;
+	m_tempPods = m_pods;
+	bool isShared = true;
+	for (int iTurn = 0; iTurn < _solution.m_nbTurnSimulated; iTurn++)
+	{
+		const array<Pod, POD_TOTAL_NB>& snapshot = _solution.m_snapshots[iTurn];
+		isShared = isShared && iTurn < _solution.m_firstCollisionTurn && false == CanOpponentsTouch(m_tempPods, snapshot);
+		if (false == isShared)
+		{
+			SimulateTurn(_solution.m_turns[iTurn].m_moves);
+			continue;
+		}
+
+		m_nbSimulatedTurn++;
+		SimulateOpponents();
+		SimulatePhysics(POD_CONTROLLABLE_NB);
+		SimulateAfterPhysics(POD_CONTROLLABLE_NB);
+		for (int iPod = 0; iPod < POD_CONTROLLABLE_NB; iPod++) m_tempPods[iPod] = snapshot[iPod];
+	}
+	m_opponentScenario = OPPONENT_SCENARIO_MODEL;
+}
+
+// Whether an opponent may come close enough to a controlled pod during the turn, whatever its thrust
+bool Simulation::CanOpponentsTouch(const array<Pod, POD_TOTAL_NB>& _pods, const array<Pod, POD_TOTAL_NB>& _snapshot) const
+{
+	for (int iPod = 0; iPod < POD_CONTROLLABLE_NB; iPod++)
+	{
+		float podTravel = Vector2::Distance(_pods[iPod].m_position, _snapshot[iPod].m_position) + PRUNING_ROUNDING_SLACK;
+		for (int iOpponent = POD_CONTROLLABLE_NB; iOpponent < POD_TOTAL_NB; iOpponent++)
+		{
+			const Pod& opponent = _pods[iOpponent];
+			float contactDistance = POD_COLLIDER_SIZE * 2.0f + podTravel + opponent.m_speed.Magnitude() + POD_MAX_THRUST + PRUNING_ROUNDING_SLACK;
+			if (Vector2::SquareDistance(_pods[iPod].m_position, opponent.m_position) < contactDistance * contactDistance) return true;
+		}
+	}
+	return false;
+}
+
+void Simulation::SetPrediction(const Solution& _solution)
+{
+	m_predictedPods = _solution.m_snapshots[0];
+	m_hasPrediction = true;
+}
+
+bool Simulation::MatchesPrediction() const
+{
+	if (false == m_hasPrediction) return false;
+
+	// Only the simulated pods are compared, the others are never predicted exactly by their model
+	for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+	{
+		const Pod& pod = m_pods[iPod];
+		const Pod& predictedPod = m_predictedPods[iPod];
+
+		if (pod.m_currentCheckpointIndex != predictedPod.m_currentCheckpointIndex) return false;
+		if (pod.m_checkpointPassedCount != predictedPod.m_checkpointPassedCount) return false;
+		if (fabs(pod.m_position.m_x - predictedPod.m_position.m_x) > PREDICTION_POSITION_TOLERANCE) return false;
+		if (fabs(pod.m_position.m_y - predictedPod.m_position.m_y) > PREDICTION_POSITION_TOLERANCE) return false;
+		if (fabs(pod.m_speed.m_x - predictedPod.m_speed.m_x) > PREDICTION_SPEED_TOLERANCE) return false;
+		if (fabs(pod.m_speed.m_y - predictedPod.m_speed.m_y) > PREDICTION_SPEED_TOLERANCE) return false;
+
+		int angleDifference = abs(pod.m_angle - predictedPod.m_angle) % 360;
+		if (min(angleDifference, 360 - angleDifference) > PREDICTION_ANGLE_TOLERANCE) return false;
+	}
+	return true;
+}
+
+array<PodOutput, POD_CONTROLLABLE_NB> Simulation::ComputeOutputsFromSolution(const Solution& _solution) const
+{
+	return ComputeOutputsFromMoves(_solution.m_turns[0].m_moves);
+}
+
+array<PodOutput, POD_CONTROLLABLE_NB> Simulation::ComputeOutputsFromMoves(const array<Move, POD_NB_TO_SIMULATE>& _moves) const
 {
+	array<PodOutput, POD_CONTROLLABLE_NB> outputs;
+
 	for (size_t iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
 	{
-		Pod& pod = m_pods[iPod];
-		const Move& move = _solution.m_turns[0].m_moves[iPod];
+		const Pod& pod = m_pods[iPod];
+		const Move& move = _moves[iPod];
+		PodOutput& output = outputs[iPod];
 
 		float angle = (pod.m_angle + move.m_rotation) % 360;
 		float angleRad = DEG_TO_RAD(angle);
 		Vector2 direction = Vector2(TARGET_DISTANCE * cos(angleRad), TARGET_DISTANCE * sin(angleRad));
-		Vector2 target = pod.m_position + direction;
+		output.m_target = pod.m_position + direction;
+		output.m_thrust = move.m_thrust;
+		output.m_useBoost = move.m_useBoost;
+		output.m_useShield = move.m_useShield;
+
+		output.m_hoverText = " ";
+		if (move.m_useBoost) output.m_hoverText += "BOOST ";
+		if (move.m_useShield) output.m_hoverText += "SHIELD ";
+		else output.m_hoverText += "THRUST_" + to_string(move.m_thrust);
+		output.m_hoverText += " ANGLE_" + to_string(move.m_rotation);
+	}
 
-		string hoverHeadText = " ";
-		if (move.m_useBoost) hoverHeadText += "BOOST ";
-		if (move.m_useShield) hoverHeadText += "SHIELD ";
-		else hoverHeadText += "THRUST_" + to_string(move.m_thrust);
-		hoverHeadText += " ANGLE_" + to_string(move.m_rotation);
+	return outputs;
+}
 
-		if (move.m_useBoost)
-		{
-			pod.m_usedBoost = true;
-			cout << target << " " << BOOST_KEYWORD << hoverHeadText << endl;
-		}
-		else if (move.m_useShield)
-		{
-			cout << target << " " << SHIELD_KEYWORD << hoverHeadText << endl;
-		}
-		else
-		{
-			cout << target << " " << move.m_thrust << hoverHeadText << endl;
-		}
+void Simulation::ApplyOutputs(const array<PodOutput, POD_CONTROLLABLE_NB>& _outputs)
+{
+	for (size_t iPod = 0; iPod < POD_CONTROLLABLE_NB; iPod++)
+	{
+		Pod& pod = m_pods[iPod];
+		if (_outputs[iPod].m_useBoost) pod.m_usedBoost = true;
+		if (_outputs[iPod].m_useShield) pod.m_shieldCooldown = POD_SHIELD_COOLDOWN;
+		else if (pod.m_shieldCooldown > 0) pod.m_shieldCooldown--;
 	}
-	if (POD_NB_TO_SIMULATE != POD_CONTROLLABLE_NB)
+}
+
+// Opponent pod the furthest in the race
+int Simulation::FindEnemyLeader(const array<Pod, POD_TOTAL_NB>& _pods) const
+{
+	int leaderIndex = POD_CONTROLLABLE_NB;
+	for (int iPod = POD_CONTROLLABLE_NB + 1; iPod < POD_TOTAL_NB; iPod++)
 	{
-		cout << m_checkpoints[m_pods[1].m_currentCheckpointIndex].m_position << " " << 100 << " DUMB POD" << endl;
+		const Pod& pod = _pods[iPod];
+		const Pod& leader = _pods[leaderIndex];
+		if (pod.m_checkpointPassedCount < leader.m_checkpointPassedCount) continue;
+		if (pod.m_checkpointPassedCount == leader.m_checkpointPassedCount
+			&& Vector2::SquareDistance(pod.m_position, m_checkpoints[pod.m_currentCheckpointIndex].m_position)
+			>= Vector2::SquareDistance(leader.m_position, m_checkpoints[leader.m_currentCheckpointIndex].m_position)) continue;
+		leaderIndex = iPod;
 	}
+	return leaderIndex;
 }
 
 void Simulation::SimulateBeforePhysics(const array<Move, POD_NB_TO_SIMULATE> _moves)
@@ -592,7 +1346,17 @@ void Simulation::SimulateBeforePhysics(const array<Move, POD_NB_TO_SIMULATE> _mo
 		float angleRad = DEG_TO_RAD(pod.m_angle);
 		Vector2 direction = Vector2(cos(angleRad), sin(angleRad));
 
-		int thrust = move.m_thrust;
+		// The shield makes the pod heavy for the turn and stops the engine for the next ones
+		pod.m_isUsingShield = false;
+		if (move.m_useShield) pod.m_shieldCooldown = POD_SHIELD_COOLDOWN + 1;
+		if (pod.m_shieldCooldown > 0)
+		{
+			pod.m_isUsingShield = pod.m_shieldCooldown == POD_SHIELD_COOLDOWN + 1;
+			pod.m_shieldCooldown--;
+			continue;
+		}
+
+		int thrust = move.m_thrust;
 		if (move.m_useBoost)
 		{
 			thrust = 0;
@@ -606,21 +1370,65 @@ void Simulation::SimulateBeforePhysics(const array<Move, POD_NB_TO_SIMULATE> _mo
 	}
 }
 
-void Simulation::SimulatePhysics()
+// The opponents play the move predicted by their model, or the one of the scenario, the boost is never predicted
+void Simulation::SimulateOpponents()
+{
+	if (false == m_useOpponentModels || m_opponentScenario == OPPONENT_SCENARIO_COAST) return;
+
+	const int blockingOpponentIndex = POD_CONTROLLABLE_NB + POD_TOTAL_NB - 1 - FindEnemyLeader(m_tempPods);
+	for (int iPod = POD_CONTROLLABLE_NB; iPod < POD_TOTAL_NB; iPod++)
+	{
+		const OpponentModel& model = m_opponentModels[iPod - POD_CONTROLLABLE_NB];
+		Pod& pod = m_tempPods[iPod];
+		Move move;
+		if (m_opponentScenario == OPPONENT_SCENARIO_BLOCK && iPod == blockingOpponentIndex)
+		{
+			move = OpponentModel::PredictBlockingMove(pod, m_tempPods[RACER_POD_INDEX]);
+		}
+		else if (m_opponentScenario == OPPONENT_SCENARIO_FULL_THRUST)
+		{
+			move = model.PredictMove(pod, m_checkpoints[pod.m_currentCheckpointIndex].m_position);
+			move.m_thrust = POD_MAX_THRUST;
+		}
+		else if (model.IsReliable()) move = model.PredictMove(pod, m_checkpoints[pod.m_currentCheckpointIndex].m_position);
+		else continue;
+
+		pod.m_angle = (pod.m_angle + move.m_rotation + 360) % 360;
+		if (pod.m_shieldCooldown > 0)
+		{
+			pod.m_shieldCooldown--;
+			continue;
+		}
+
+		float angleRad = DEG_TO_RAD(pod.m_angle);
+		pod.m_speed += Vector2(cos(angleRad), sin(angleRad)) * (float)move.m_thrust;
+	}
+}
+
+// Pods before the first index are left out, along with their collisions
+void Simulation::SimulatePhysics(int _firstPodIndex)
 {
+	// No pair can touch during the rollouts, only the motion is left
+	if (m_areAllPodsIsolated)
+	{
+		for (int iPod = _firstPodIndex; iPod < POD_TOTAL_NB; iPod++) MovePod(&m_tempPods[iPod], 1.0f);
+		return;
+	}
+
 	float time = 0.0f;
 	float endTime = 1.0f;
 	while (time < endTime)
 	{
 		float deltaTime = endTime - time;
 
-		for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+		for (int iPod = _firstPodIndex; iPod < POD_TOTAL_NB; iPod++)
 		{
 			Pod& pod = m_tempPods[iPod];
 
 			// Check other pods collisions
-			for (int iOtherPod = 0; iOtherPod < POD_TOTAL_NB; iOtherPod++)
+			for (int iOtherPod = _firstPodIndex; iOtherPod < POD_TOTAL_NB; iOtherPod++)
 			{
+				if (m_isPodIsolated[iPod] && m_isPodIsolated[iOtherPod]) continue;
 				Pod otherPod = m_tempPods[iOtherPod];
 				if (otherPod == pod) continue;
 
@@ -630,26 +1438,33 @@ void Simulation::SimulatePhysics()
 
 				///cerr << "Collision in simulation" << endl;
 				Pod::Bounce(&m_tempPods[iPod], &m_tempPods[iOtherPod]);
+				m_hasCollided = true;
+				m_isPodIsolated[iPod] = false;
+				m_isPodIsolated[iOtherPod] = false;
 			}
 
-			pod.m_position += pod.m_speed * deltaTime; // Move the pod
-
-			// Check checkpoints collisions
-			if (Vector2::SquareDistance(pod.m_position, m_checkpoints[pod.m_currentCheckpointIndex].m_position) < (CHECKPOINT_RADIUS * CHECKPOINT_RADIUS))
-			{
-				//cerr << "collision with checkpoint in sumulation" << endl;
-				pod.m_currentCheckpointIndex = (pod.m_currentCheckpointIndex + 1) % m_checkpointCount_Lap;
-				pod.m_checkpointPassedCount++;
-			}
+			MovePod(&pod, deltaTime);
 		}
 
 		time += deltaTime;
 	}
 }
 
-void Simulation::SimulateAfterPhysics()
+void Simulation::MovePod(Pod* _pod, float _deltaTime)
 {
-	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	_pod->m_position += _pod->m_speed * _deltaTime;
+
+	// Check checkpoints collisions
+	if (Vector2::SquareDistance(_pod->m_position, m_checkpoints[_pod->m_currentCheckpointIndex].m_position) < (CHECKPOINT_RADIUS * CHECKPOINT_RADIUS))
+	{
+		_pod->m_currentCheckpointIndex = (_pod->m_currentCheckpointIndex + 1) % m_checkpointCount_Lap;
+		_pod->m_checkpointPassedCount++;
+	}
+}
+
+void Simulation::SimulateAfterPhysics(int _firstPodIndex)
+{
+	for (int iPod = _firstPodIndex; iPod < POD_TOTAL_NB; iPod++)
 	{
 		Pod& pod = m_tempPods[iPod];
 
@@ -660,144 +1475,1673 @@ void Simulation::SimulateAfterPhysics()
 
 #pragma endregion
 
+#pragma region Heuristic Policy Class
+
+// Steering of BronzeToGold.cpp PlayerPod (UpdateThrust, UpdateTarget and CheckShouldBoost) expressed as moves
+class HeuristicPolicy
+{
+public:
+
+	static Move ComputeMove(const Pod& _pod, const Simulation& _simulation);
+	static Move ComputeBlockerMove(const Pod& _pod, const Pod& _target, const Simulation& _simulation);
+	static Move ComputeRoleMove(const array<Pod, POD_TOTAL_NB>& _pods, int _podIndex, const Simulation& _simulation);
+	static void Rollout(Simulation* _simulation, Solution* _solution, int _nbTurnSimulated, int _firstTurn = 0, int _podIndex = RACER_POD_INDEX);
+	static array<PodOutput, POD_CONTROLLABLE_NB> ComputeOutputs(const Simulation& _simulation);
+};
+
+Move HeuristicPolicy::ComputeMove(const Pod& _pod, const Simulation& _simulation)
+{
+	Move move;
+
+	const Vector2& checkpointPosition = _simulation.m_checkpoints[_pod.m_currentCheckpointIndex].m_position;
+	Vector2 podToCheckpoint = checkpointPosition - _pod.m_position;
+	float distanceToCheckpoint = podToCheckpoint.Magnitude();
+
+	// Aim at an offset of the checkpoint position, or of its racing line point, taking into account the pod speed
+	Vector2 target = checkpointPosition;
+	if (_simulation.m_hasRacingLine) target = _simulation.m_racingLine[_pod.m_currentCheckpointIndex];
+	target += _pod.m_speed * TARGET_SPEED_OFFSET_MULTIPLIER;
+	Vector2 podToTarget = target - _pod.m_position;
+	float targetAngle = RAD_TO_DEG(atan2(podToTarget.m_y, podToTarget.m_x));
+	float rotation = fmod(targetAngle - _pod.m_angle + 540.0f, 360.0f) - 180.0f;
+	move.m_rotation = (int)round(clamp(rotation, -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION));
+
+	// Slow down when turning to the checkpoint and as the pod gets closer to it
+	float checkpointAngle = RAD_TO_DEG(atan2(podToCheckpoint.m_y, podToCheckpoint.m_x));
+	float angleToCheckpoint = fabs(fmod(checkpointAngle - (_pod.m_angle + move.m_rotation) + 540.0f, 360.0f) - 180.0f);
+	float turningMultiplier = clamp(1.0f - angleToCheckpoint / THRUST_ANGLE_BEFORE_TURNING, 0.0f, 1.0f);
+	float brakingMultiplier = clamp(distanceToCheckpoint / THRUST_DISTANCE_BEFORE_BRAKING, THRUST_MINIMUM_BRACKING_MULTIPLIER, 1.0f);
+	move.m_thrust = (int)(POD_MAX_THRUST * turningMultiplier * brakingMultiplier);
+
+	bool shouldBoost = _pod.CanBoost() && angleToCheckpoint < BOOST_THRESHOLD_ANGLE && distanceToCheckpoint > BOOST_THRESHOLD_DISTANCE_TO_CHECKPOINT;
+	if (shouldBoost)
+	{
+		move.m_useBoost = true;
+		move.m_thrust = 0;
+	}
+
+	return move;
+}
+
+// Goes to meet the target pod, or waits for it on its next checkpoint when it is too far ahead
+Move HeuristicPolicy::ComputeBlockerMove(const Pod& _pod, const Pod& _target, const Simulation& _simulation)
+{
+	Move move;
+
+	const Vector2& targetCheckpointPosition = _simulation.m_checkpoints[_target.m_currentCheckpointIndex].m_position;
+	Vector2 target = _target.m_position + _target.m_speed * BLOCKER_INTERCEPT_TURNS;
+	if (Vector2::SquareDistance(_pod.m_position, targetCheckpointPosition) > Vector2::SquareDistance(_target.m_position, targetCheckpointPosition))
+	{
+		int nextCheckpointIndex = (_target.m_currentCheckpointIndex + 1) % _simulation.m_checkpointCount_Lap;
+		target = _simulation.m_checkpoints[nextCheckpointIndex].m_position;
+	}
+
+	Vector2 podToTarget = target - _pod.m_position;
+	float targetAngle = RAD_TO_DEG(atan2(podToTarget.m_y, podToTarget.m_x));
+	float rotation = fmod(targetAngle - _pod.m_angle + 540.0f, 360.0f) - 180.0f;
+	move.m_rotation = (int)round(clamp(rotation, -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION));
+
+	float angleToTarget = fabs(rotation - move.m_rotation);
+	move.m_thrust = (int)(POD_MAX_THRUST * clamp(1.0f - angleToTarget / THRUST_ANGLE_BEFORE_TURNING, 0.0f, 1.0f));
+
+	return move;
+}
+
+Move HeuristicPolicy::ComputeRoleMove(const array<Pod, POD_TOTAL_NB>& _pods, int _podIndex, const Simulation& _simulation)
+{
+	if (_podIndex == BLOCKER_POD_INDEX) return ComputeBlockerMove(_pods[_podIndex], _pods[_simulation.FindEnemyLeader(_pods)], _simulation);
+	return ComputeMove(_pods[_podIndex], _simulation);
+}
+
+array<PodOutput, POD_CONTROLLABLE_NB> HeuristicPolicy::ComputeOutputs(const Simulation& _simulation)
+{
+	array<Move, POD_NB_TO_SIMULATE> moves;
+	for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+	{
+		moves[iPod] = ComputeRoleMove(_simulation.m_pods, iPod, _simulation);
+	}
+	return _simulation.ComputeOutputsFromMoves(moves);
+}
+
+// Only the moves of the given pod are computed, the other pods keep the moves of the solution
+void HeuristicPolicy::Rollout(Simulation* _simulation, Solution* _solution, int _nbTurnSimulated, int _firstTurn, int _podIndex)
+{
+	// Starts from the snapshot of the turn before, which must be up to date, and leaves the rollout simulated
+	_simulation->SimulateSolution(*_solution, _firstTurn, _firstTurn);
+	for (int iTurn = _firstTurn; iTurn < _nbTurnSimulated; iTurn++)
+	{
+		_solution->m_turns[iTurn].m_moves[_podIndex] = ComputeRoleMove(_simulation->m_tempPods, _podIndex, *_simulation);
+		_simulation->ContinueSolution(*_solution);
+	}
+}
+
+#pragma endregion
+
+#pragma region Transposition Table Class
+
+#define TRANSPOSITION_KEY_WORDS ((NB_TURN_SIMULATED_MAX * POD_NB_TO_SIMULATE * TRANSPOSITION_MOVE_BITS + 5 + 63) / 64)
+
+// Open addressing table from a packed genome to its score, only valid for one state and one turn
+class TranspositionTable
+{
+public:
+
+	typedef array<uint64_t, TRANSPOSITION_KEY_WORDS> Key;
+
+	TranspositionTable() : m_entries(TRANSPOSITION_TABLE_SIZE) {}
+
+	static Key Pack(const Solution& _solution, int _nbTurnSimulated);
+	static void Append(Key* _key, int* _bit, uint64_t _value, int _nbBit);
+
+	void Clear() { m_generation++; } // Entries of the previous generations are considered empty
+	bool Find(const Key& _key, int* _score) const;
+	void Store(const Key& _key, int _score);
+
+private:
+
+	struct Entry
+	{
+		Key m_key = {};
+		int m_score = -1;
+		uint32_t m_generation = 0;
+	};
+
+	static size_t Hash(const Key& _key);
+
+	vector<Entry> m_entries;
+	uint32_t m_generation = 1;
+};
+
+TranspositionTable::Key TranspositionTable::Pack(const Solution& _solution, int _nbTurnSimulated)
+{
+	Key key = {};
+	int bit = 0;
+
+	// The horizon is part of the key, the same moves do not score the same on another depth
+	key[0] = (uint64_t)_nbTurnSimulated;
+	bit += 4;
+
+	// The moves of a macro-action genome are only known after its rollout, the actions are packed instead
+	// behind a bit that the moves never reach. The other pod follows the partner plan, the same for every solution of the turn.
+	if (_solution.m_nbMacroAction > 0)
+	{
+		int genomeBit = 4 + NB_TURN_SIMULATED_MAX * POD_NB_TO_SIMULATE * TRANSPOSITION_MOVE_BITS;
+		Append(&key, &genomeBit, 1, 1);
+		for (int iAction = 0; iAction < _solution.m_nbMacroAction; iAction++)
+		{
+			const MacroAction& action = _solution.m_macroActions[iAction];
+			uint64_t packedAction = (uint64_t)action.m_checkpointOffset
+				| ((uint64_t)(action.m_aimOffset + MACRO_ACTION_MAXIMUM_AIM_OFFSET) << 1)
+				| ((uint64_t)action.m_thrust << 13)
+				| ((uint64_t)action.m_useBoost << 20)
+				| ((uint64_t)action.m_nbTurn << 21);
+			Append(&key, &bit, packedAction, TRANSPOSITION_MACRO_ACTION_BITS);
+		}
+		return key;
+	}
+
+	for (int iTurn = 0; iTurn < _nbTurnSimulated; iTurn++)
+	{
+		for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+		{
+			const Move& move = _solution.m_turns[iTurn].m_moves[iPod];
+			uint64_t packedMove = (uint64_t)(move.m_rotation + (int)POD_MAXIMUM_ROTATION)
+				| ((uint64_t)move.m_thrust << 6)
+				| ((uint64_t)move.m_useBoost << 13)
+				| ((uint64_t)move.m_useShield << 14);
+			Append(&key, &bit, packedMove, TRANSPOSITION_MOVE_BITS);
+		}
+	}
+
+	return key;
+}
+
+void TranspositionTable::Append(Key* _key, int* _bit, uint64_t _value, int _nbBit)
+{
+	int word = *_bit / 64;
+	int offset = *_bit % 64;
+	(*_key)[word] |= _value << offset;
+	if (offset + _nbBit > 64) (*_key)[word + 1] |= _value >> (64 - offset);
+	*_bit += _nbBit;
+}
+
+size_t TranspositionTable::Hash(const Key& _key)
+{
+	uint64_t hash = 0;
+	for (uint64_t word : _key)
+	{
+		hash ^= word + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+		hash = (hash ^ (hash >> 31)) * 0xBF58476D1CE4E5B9ULL;
+	}
+	return (size_t)(hash ^ (hash >> 29));
+}
+
+bool TranspositionTable::Find(const Key& _key, int* _score) const
+{
+	size_t index = Hash(_key);
+	for (int iProbe = 0; iProbe < TRANSPOSITION_MAXIMUM_PROBES; iProbe++)
+	{
+		const Entry& entry = m_entries[(index + iProbe) & (TRANSPOSITION_TABLE_SIZE - 1)];
+		if (entry.m_generation != m_generation) return false;
+		if (entry.m_key == _key)
+		{
+			*_score = entry.m_score;
+			return true;
+		}
+	}
+	return false;
+}
+
+void TranspositionTable::Store(const Key& _key, int _score)
+{
+	size_t index = Hash(_key);
+	for (int iProbe = 0; iProbe < TRANSPOSITION_MAXIMUM_PROBES; iProbe++)
+	{
+		Entry& entry = m_entries[(index + iProbe) & (TRANSPOSITION_TABLE_SIZE - 1)];
+		if (entry.m_generation != m_generation || entry.m_key == _key)
+		{
+			entry.m_key = _key;
+			entry.m_score = _score;
+			entry.m_generation = m_generation;
+			return;
+		}
+	}
+
+	// Every probed slot is taken, the first one is replaced
+	Entry& entry = m_entries[index & (TRANSPOSITION_TABLE_SIZE - 1)];
+	entry.m_key = _key;
+	entry.m_score = _score;
+}
+
+#pragma endregion
+
 #pragma region Solver Class
 
+enum MutationOperator
+{
+	MUTATION_REGENERATE, // New random moves on every turn
+	MUTATION_ROTATION_NUDGE,
+	MUTATION_THRUST_NUDGE,
+	MUTATION_TOGGLE_BOOST,
+	MUTATION_TOGGLE_SHIELD, // Blocker only
+	MUTATION_SHIFT_TURN, // Play the plan one turn earlier or later
+	MUTATION_COPY_FROM_ELITE, // End of the plan taken from the best solution
+	MUTATION_HEURISTIC_INJECTION, // End of the plan played by the heuristic
+	MUTATION_OPERATOR_COUNT
+};
+
 class Solver
 {
 public:
 
-	Solver(Simulation* _simulation);
+	Solver(Simulation* _simulation, const SearchParameters& _parameters = SearchParameters(), int _podIndex = RACER_POD_INDEX);
 	const Solution& Solve();
 
+	// Solve split in phases so the search can also run between turns
+	void BeginTurn(bool _isPopulationShifted = false);
+	void Search(int _timeAllocated, const atomic<bool>* _shouldStop = nullptr);
+	const Solution& EndTurn();
+
+	void SetSimulation(Simulation* _simulation) { m_simulation = _simulation; }
+	bool HasBeatenHeuristic() const { return m_solutions[0].m_score > m_heuristicSolution.m_score; } // The seeded heuristic plan itself does not count
+	void AdoptPopulation(const Solver& _solver);
+	int GetSolutionCreatedCount() const { return m_nbSolutionCreated; }
+	int GetSolutionFoundCount() const { return m_nbSolutionFound; }
+	int GetHorizon() const { return m_nbTurnSimulated; }
+	const SearchParameters& GetParameters() const { return m_parameters; }
+	bool IsInEndgame() const;
+	void SetOpening(const vector<Turn>& _openingTurns) { m_openingTurns = _openingTurns; }
+	int GetCacheHitCount() const { return m_nbCacheHit; }
+	int GetSolutionPrunedCount() const { return m_nbSolutionPruned; }
+	bool IsRacer() const { return m_podIndex == RACER_POD_INDEX; }
+	bool UsesMacroActions() const { return IsRacer() && m_parameters.m_genome == GENOME_MACRO_ACTIONS; }
+	void SetPartnerPlan(const Solution& _solution, int _firstTurn); // Moves of the other controlled pod, fixed during the search
+	void SetPlayedMoves(const array<Move, POD_NB_TO_SIMULATE>& _moves) { m_playedMoves = _moves; }
+	float GetSimulatedTurnsPerMillisecond() const { return m_simulatedTurnsPerMillisecond; }
+
 private:
 
 	void GeneratePopulation();
-	void Mutate(Solution* _solution);
+	int ChooseHorizon() const;
+	bool SimulateCandidate(Solution* _solution, int _firstTurn);
+	void SimulatePlan(Solution* _solution, int _nbTurnSimulated, int _firstTurn = 0);
+	void ExpandMacroAction(Solution* _solution, int _turn) const;
+	bool CanBeatScore(const Simulation& _simulation, int _nbTurnLeft, int _scoreToBeat) const;
+	bool SolveEndgame(int _timeAllocated);
+	bool SearchEndgame(Solution* _solution, int _turn, int _depth);
+	int SelectMutationOperator() const;
+	void RewardMutationOperator(int _operator, bool _hasImproved);
+	int Mutate(Solution* _solution, int _operator);
+	int MutateMacroActions(Solution* _solution, int _operator);
+	int ApplyPartnerMoves(Solution* _solution) const;
 	int EvaluateSolution(Solution* _solution, const Simulation& _simulation);
+	int EvaluatePods(const array<Pod, POD_TOTAL_NB>& _pods, const Simulation& _simulation) const;
+	int EvaluateScenarios(const Solution& _solution, int _firstScenarioScore);
+	int ComputeAggregatedScenarioCount() const;
+	long long ComputeSimulationBudget(int _timeAllocated) const;
 
 	Simulation* m_simulation = nullptr;
+	SearchParameters m_parameters;
+	int m_podIndex = RACER_POD_INDEX; // Controlled pod searched, its role decides the evaluation
+	int m_partnerIndex = BLOCKER_POD_INDEX;
+	array<Move, NB_TURN_SIMULATED_MAX> m_partnerMoves; // Coasting until a partner plan is given
+	int m_targetPodIndex = POD_CONTROLLABLE_NB; // Opponent harassed by the blocker this turn
 	vector<Solution> m_solutions;
+	array<Move, POD_NB_TO_SIMULATE> m_playedMoves; // First moves of the solution returned last turn
+	Solution m_heuristicSolution; // Baseline plan of the turn
 	int m_minimumScore = -1;
+	int m_nbTurnSimulated = NB_TURN_SIMULATED; // Horizon of the current turn
+	float m_simulatedTurnsPerMillisecond = 0.0f; // Measured simulation rate, smoothed over the turns
+	TranspositionTable m_transpositionTable;
+	int m_bestSolutionIndex = 0;
+	vector<Turn> m_openingTurns; // Moves of the first turns of the race, found by the map analysis
+
+	// Endgame search state
+	high_resolution_clock::time_point m_endgameDeadline;
+	long long m_endgameSimulationLimit = 0; // Replaces the deadline when searching on a simulation budget
+	bool m_isEndgameTimeOut = false;
+	long long m_nbEndgameNode = 0;
+
+	// Discounted statistics of the mutation operators, kept from a turn to the next
+	array<float, MUTATION_OPERATOR_COUNT> m_operatorPulls = {};
+	array<float, MUTATION_OPERATOR_COUNT> m_operatorRewards = {};
+	float m_operatorTotalPulls = 0.0f;
+
+	// Statistics of the current turn
+	int m_lastScore = -1;
+	int m_nbSolutionCreated = 0;
+	int m_nbSolutionFound = 0;
+	int m_nbRolloutReused = 0;
+	int m_nbCacheHit = 0;
+	int m_nbSolutionPruned = 0;
+	int m_nbSoftDeadlineStop = 0; // Whole game, searches given up below the heuristic plan
+	int m_nbTurnPruned = 0;
+	array<int, MUTATION_OPERATOR_COUNT> m_nbOperatorUsed = {};
+	array<int, MUTATION_OPERATOR_COUNT> m_nbOperatorImproved = {};
 };
 
-Solver::Solver(Simulation* _simulation)
+Solver::Solver(Simulation* _simulation, const SearchParameters& _parameters, int _podIndex)
 {
 	m_simulation = _simulation;
-	m_solutions.resize(SOLUTIONS_COUNT);
+	m_parameters = _parameters;
+	m_podIndex = _podIndex;
+	m_partnerIndex = POD_NB_TO_SIMULATE - 1 - _podIndex;
+	m_parameters.m_nbTurnSimulated = clamp(m_parameters.m_nbTurnSimulated, 1, NB_TURN_SIMULATED_MAX);
+	m_parameters.m_solutionsCount = max(m_parameters.m_solutionsCount, 1);
+	m_nbTurnSimulated = m_parameters.m_nbTurnSimulated;
+	m_solutions.resize(m_parameters.m_solutionsCount);
+	if (m_parameters.m_simulationBudget > 0) Random::SetSeed(m_parameters.m_seed + (unsigned int)_podIndex);
 	GeneratePopulation();
 }
 
 void Solver::GeneratePopulation()
 {
-	cerr << "Start to generate population" << endl;
-	for (int iSolution = 0; iSolution < SOLUTIONS_COUNT; iSolution++)
+	DEBUG_LOG << "Start to generate population" << endl;
+	for (int iSolution = 0; iSolution < m_parameters.m_solutionsCount; iSolution++)
+	{
+		for (int iTurn = 0; iTurn < m_parameters.m_nbTurnSimulated; iTurn++)
+		{
+			m_solutions[iSolution].m_turns[iTurn].m_moves[m_podIndex] = Solution::GenerateMove(m_simulation->m_pods[m_podIndex], m_parameters);
+		}
+		m_solutions[iSolution].m_nbTurnSimulated = m_parameters.m_nbTurnSimulated;
+	}
+	DEBUG_LOG << "Population generated" << endl;
+}
+
+int Solver::ChooseHorizon() const
+{
+	const int defaultHorizon = m_parameters.m_nbTurnSimulated;
+	if (false == m_parameters.m_isHorizonAdaptive) return clamp(defaultHorizon, 1, NB_TURN_SIMULATED_MAX);
+
+	// A macro-action genome does not grow with the horizon, it always looks as far as it can
+	if (UsesMacroActions()) return clamp(m_parameters.m_macroActionHorizon, 1, NB_TURN_SIMULATED_MAX);
+
+	// The measured rate bounds the horizon so that the budget still affords the same number of evaluations
+	int affordableHorizon = NB_TURN_SIMULATED_MAX;
+	if (m_parameters.m_simulationBudget > 0)
+	{
+		affordableHorizon = m_parameters.m_simulationBudget / max(m_parameters.m_evaluationsPerTurn, 1);
+	}
+	else if (m_simulatedTurnsPerMillisecond > 0.0f)
+	{
+		float affordableTurns = m_simulatedTurnsPerMillisecond * m_parameters.m_timeAllocatedPerTurn;
+		affordableHorizon = (int)(affordableTurns / max(m_parameters.m_evaluationsPerTurn, 1));
+	}
+
+	const Pod& pod = m_simulation->m_pods[m_podIndex];
+	Vector2 podToCheckpoint = m_simulation->m_checkpoints[pod.m_currentCheckpointIndex].m_position - pod.m_position;
+	float distanceToCheckpoint = podToCheckpoint.Magnitude();
+	float speed = max(pod.m_speed.Magnitude(), 1.0f);
+
+	bool isCrowded = false;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		if (iPod == m_podIndex) continue;
+		float squareDistance = Vector2::SquareDistance(pod.m_position, m_simulation->m_pods[iPod].m_position);
+		if (squareDistance < HORIZON_CROWDED_DISTANCE * HORIZON_CROWDED_DISTANCE) isCrowded = true;
+	}
+	bool isNearCheckpoint = (distanceToCheckpoint - CHECKPOINT_RADIUS) / speed < HORIZON_NEAR_CHECKPOINT_TURNS;
+	bool isOnStraight = distanceToCheckpoint > HORIZON_STRAIGHT_DISTANCE
+		&& Vector2::Angle(pod.m_speed.Normalized(), podToCheckpoint.Normalized()) < HORIZON_STRAIGHT_ANGLE;
+
+	// Deeper when nothing can happen for a while, shallower when the next turns are chaotic
+	int horizon = defaultHorizon;
+	if (isCrowded || isNearCheckpoint) horizon = defaultHorizon - 1;
+	else if (isOnStraight) horizon = NB_TURN_SIMULATED_MAX;
+
+	horizon = min(horizon, affordableHorizon);
+	return clamp(horizon, min(NB_TURN_SIMULATED_MIN, defaultHorizon), NB_TURN_SIMULATED_MAX);
+}
+
+const Solution& Solver::Solve()
+{
+	BeginTurn();
+	Search(m_parameters.m_timeAllocatedPerTurn);
+	return EndTurn();
+}
+
+void Solver::BeginTurn(bool _isPopulationShifted)
+{
+	m_lastScore = -1;
+	m_nbSolutionCreated = 0;
+	m_nbSolutionFound = 0;
+	m_nbRolloutReused = 0;
+	m_nbCacheHit = 0;
+	m_nbSolutionPruned = 0;
+	m_nbTurnPruned = 0;
+	m_nbOperatorUsed = {};
+	m_nbOperatorImproved = {};
+	m_transpositionTable.Clear();
+
+	// An adopted population keeps the horizon it was searched with
+	if (false == _isPopulationShifted) m_nbTurnSimulated = ChooseHorizon();
+	const int nbTurnSimulated = m_nbTurnSimulated;
+	m_simulation->AnalyseProximity(IsInEndgame() ? max(nbTurnSimulated, ENDGAME_MAXIMUM_DEPTH) : nbTurnSimulated);
+
+	// When last turn went as planned, solutions that started with the played move keep their rollouts
+	// and only their new turns are simulated
+	const bool canReuseRollouts = false == _isPopulationShifted && m_simulation->MatchesPrediction();
+	m_targetPodIndex = m_simulation->FindEnemyLeader(m_simulation->m_pods);
+
+	ApplyPartnerMoves(&m_heuristicSolution);
+	HeuristicPolicy::Rollout(m_simulation, &m_heuristicSolution, nbTurnSimulated, 0, m_podIndex);
+	EvaluateSolution(&m_heuristicSolution, *m_simulation);
+	m_transpositionTable.Store(TranspositionTable::Pack(m_heuristicSolution, nbTurnSimulated), m_heuristicSolution.m_score);
+
+	m_solutions.resize(m_parameters.m_solutionsCount);
+	const int firstSeedIndex = max(m_parameters.m_solutionsCount - m_parameters.m_heuristicSeedsCount, 0);
+	for (int iSolution = 0; iSolution < m_parameters.m_solutionsCount; iSolution++)
 	{
-		for (int iTurn = 0; iTurn < NB_TURN_SIMULATED; iTurn++)
+		Solution& solution = m_solutions[iSolution];
+
+		// The last solutions of the population are replaced by the heuristic plan from the current state
+		if (iSolution >= firstSeedIndex)
+		{
+			solution = m_heuristicSolution;
+			if (UsesMacroActions())
+			{
+				// Its closest plan of actions: straight at the checkpoint at full thrust
+				solution.m_nbMacroAction = 1;
+				solution.m_macroActions[0] = MacroAction();
+				solution.m_macroActions[0].m_nbTurn = nbTurnSimulated;
+				SimulatePlan(&solution, nbTurnSimulated);
+				int currentScore = EvaluateSolution(&solution, *m_simulation);
+				m_transpositionTable.Store(TranspositionTable::Pack(solution, nbTurnSimulated), currentScore);
+			}
+			if (solution.m_score > m_lastScore) m_lastScore = solution.m_score;
+			continue;
+		}
+
+		// The solution before the heuristic seeds follows the opening while it lasts
+		bool isInOpening = m_simulation->m_turn < (int)m_openingTurns.size() && false == UsesMacroActions();
+		if (iSolution == firstSeedIndex - 1 && isInOpening)
 		{
-			for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+			int nbOpeningTurn = min((int)m_openingTurns.size() - m_simulation->m_turn, nbTurnSimulated);
+			for (int iTurn = 0; iTurn < nbOpeningTurn; iTurn++)
 			{
-				m_solutions[iSolution].m_turns[iTurn].m_moves[iPod] = Solution::GenerateMove(m_simulation->m_pods[iPod]);
+				solution.m_turns[iTurn].m_moves[m_podIndex] = m_openingTurns[m_simulation->m_turn + iTurn].m_moves[m_podIndex];
 			}
+			ApplyPartnerMoves(&solution);
+			m_simulation->SimulateSolution(solution, nbOpeningTurn);
+			HeuristicPolicy::Rollout(m_simulation, &solution, nbTurnSimulated, nbOpeningTurn, m_podIndex);
+			int currentScore = EvaluateSolution(&solution, *m_simulation);
+			m_transpositionTable.Store(TranspositionTable::Pack(solution, nbTurnSimulated), currentScore);
+			if (currentScore > m_lastScore) m_lastScore = currentScore;
+			continue;
+		}
+
+		if (_isPopulationShifted)
+		{
+			ApplyPartnerMoves(&solution);
+			if (UsesMacroActions() && solution.m_nbMacroAction == 0) solution.GenerateMacroActions(m_simulation->m_pods[m_podIndex], m_parameters, nbTurnSimulated);
+			SimulatePlan(&solution, nbTurnSimulated);
+			int currentScore = EvaluateSolution(&solution, *m_simulation);
+			m_transpositionTable.Store(TranspositionTable::Pack(solution, nbTurnSimulated), currentScore);
+			if (currentScore > m_lastScore) m_lastScore = currentScore;
+			continue;
+		}
+
+		bool isOnPlayedPath = canReuseRollouts && solution.m_turns[0].m_moves == m_playedMoves;
+		int nbTurnKept = min(solution.ShiftTurn(m_simulation->m_tempPods, m_parameters, nbTurnSimulated), nbTurnSimulated);
+
+		// The kept rollout is only valid up to the first turn where the partner plan changed
+		int nbTurnValid = min(nbTurnKept, ApplyPartnerMoves(&solution));
+		int firstTurn = 0;
+		if (isOnPlayedPath && nbTurnValid > 0 && solution.m_firstCollisionTurn >= nbTurnValid)
+		{
+			firstTurn = nbTurnValid;
+			m_nbRolloutReused++;
+		}
+
+		// A new plan of actions for the solutions generated with moves, their last action covers the new turns otherwise
+		if (UsesMacroActions() && solution.m_nbMacroAction == 0)
+		{
+			solution.GenerateMacroActions(m_simulation->m_pods[m_podIndex], m_parameters, nbTurnSimulated);
+			firstTurn = 0;
+		}
+
+		// The new turns can follow the heuristic from the state reached at the end of the shifted plan
+		bool shouldAppendHeuristic = Random::Range(0, 100) < m_parameters.m_probabilityToAppendHeuristic;
+		if (shouldAppendHeuristic && solution.m_nbMacroAction == 0)
+		{
+			int firstHeuristicTurn = min(nbTurnKept, nbTurnSimulated - 1);
+			m_simulation->SimulateSolution(solution, firstHeuristicTurn, min(firstTurn, firstHeuristicTurn));
+			HeuristicPolicy::Rollout(m_simulation, &solution, nbTurnSimulated, firstHeuristicTurn, m_podIndex);
+			firstTurn = nbTurnSimulated;
 		}
+
+		SimulatePlan(&solution, nbTurnSimulated, firstTurn);
+		int currentScore = EvaluateSolution(&solution, *m_simulation);
+		m_transpositionTable.Store(TranspositionTable::Pack(solution, nbTurnSimulated), currentScore);
+		if (currentScore > m_lastScore) m_lastScore = currentScore;
 	}
-	cerr << "Population generated" << endl;
 }
 
-const Solution& Solver::Solve()
+void Solver::Search(int _timeAllocated, const atomic<bool>* _shouldStop)
 {
 	auto startTime = high_resolution_clock::now();
-	int timepassed = 0;
+	long long firstSimulatedTurnCount = m_simulation->GetSimulatedTurnCount();
+	const int firstCacheHitCount = m_nbCacheHit;
+	const long long simulationBudget = ComputeSimulationBudget(_timeAllocated);
 
-	int nbSolutionCreated = 0;
-	int nbSolutionFound = 0;
+	// A skipped duplicate is charged one simulated turn, so that a converged population still ends the search
+	auto isSearchOver = [&]()
+	{
+		if (simulationBudget > 0) return m_simulation->GetSimulatedTurnCount() - firstSimulatedTurnCount + m_nbCacheHit - firstCacheHitCount >= simulationBudget;
+		return duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count() >= _timeAllocated;
+	};
+	auto isPastSoftDeadline = [&]()
+	{
+		if (simulationBudget > 0) return (m_simulation->GetSimulatedTurnCount() - firstSimulatedTurnCount + m_nbCacheHit - firstCacheHitCount) * 100 >= simulationBudget * HEURISTIC_SOFT_DEADLINE_SHARE;
+		return duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count() * 100 >= _timeAllocated * HEURISTIC_SOFT_DEADLINE_SHARE;
+	};
 
-	int lastScore = -1;
+	// Close to the finish line the fewest turns can be found exactly, the genetic search is only used if it fails
+	if (IsInEndgame() && SolveEndgame(_timeAllocated * ENDGAME_TIME_SHARE / 100)) return;
 
-	m_solutions.resize(SOLUTIONS_COUNT);
-	for (size_t iSolution = 0; iSolution < SOLUTIONS_COUNT; iSolution++)
+	m_bestSolutionIndex = 0;
+	for (int iSolution = 0; iSolution < (int)m_solutions.size(); iSolution++)
 	{
-		Solution& solution = m_solutions[iSolution];
-		solution.ShiftTurn(m_simulation->m_tempPods);
-		m_simulation->SimulateSolution(solution);
-		int currentScore = EvaluateSolution(&solution, *m_simulation);
-		if (currentScore > lastScore) lastScore = currentScore;
+		if (m_solutions[iSolution].m_score > m_solutions[m_bestSolutionIndex].m_score) m_bestSolutionIndex = iSolution;
 	}
 
-	while (timepassed < TIME_ALLOCATED_PER_TURN)
+	while (false == isSearchOver())
 	{
-		Solution solution = m_solutions[Random::Range(0, SOLUTIONS_COUNT)];
-		Mutate(&solution);
-		m_simulation->SimulateSolution(solution);
+		if (_shouldStop != nullptr && _shouldStop->load(memory_order_relaxed)) break;
+
+		// Still not above the baseline at the soft deadline, the heuristic plan is played and the rest of the turn goes to the next search
+		if (_shouldStop == nullptr && m_lastScore <= m_heuristicSolution.m_score && isPastSoftDeadline())
+		{
+			m_nbSoftDeadlineStop++;
+			break;
+		}
+
+		// Local operators refine the best solution, the others explore from the whole population
+		int mutationOperator = SelectMutationOperator();
+		bool isLocalOperator = mutationOperator != MUTATION_REGENERATE && mutationOperator != MUTATION_COPY_FROM_ELITE;
+		int parentIndex = isLocalOperator ? m_bestSolutionIndex : Random::Range(0, m_parameters.m_solutionsCount);
+		Solution solution = m_solutions[parentIndex];
+		int firstTurn = Mutate(&solution, mutationOperator);
+		m_nbSolutionCreated++;
+		m_nbOperatorUsed[mutationOperator]++;
+
+		// A genome already scored this turn cannot beat the best score, which only grows
+		int cachedScore = -1;
+		TranspositionTable::Key key = TranspositionTable::Pack(solution, m_nbTurnSimulated);
+		if (m_transpositionTable.Find(key, &cachedScore))
+		{
+			m_nbCacheHit++;
+			RewardMutationOperator(mutationOperator, false);
+			continue;
+		}
+
+		if (false == SimulateCandidate(&solution, firstTurn))
+		{
+			// The score is unknown but below the best one, which is all the table needs to know
+			m_transpositionTable.Store(key, m_lastScore);
+			RewardMutationOperator(mutationOperator, false);
+			continue;
+		}
+
 		int currentScore = EvaluateSolution(&solution, *m_simulation);
-		nbSolutionCreated++;
-		if (currentScore > lastScore)
+		m_transpositionTable.Store(key, currentScore);
+		RewardMutationOperator(mutationOperator, currentScore > m_lastScore);
+		if (currentScore > m_lastScore)
 		{
-			lastScore = currentScore;
+			m_lastScore = currentScore;
+			m_bestSolutionIndex = (int)m_solutions.size();
 			m_solutions.push_back(solution);
-			nbSolutionFound++;
+			m_nbSolutionFound++;
+			m_nbOperatorImproved[mutationOperator]++;
 		}
-		timepassed = duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count();
 	}
 
-	cerr << nbSolutionFound << " good solutions have been found for " << nbSolutionCreated << " created." << endl;
+	// Measure the simulation rate for the next horizon choice
+	long long elapsedMicroseconds = duration_cast<microseconds>(high_resolution_clock::now() - startTime).count();
+	if (elapsedMicroseconds > 0)
+	{
+		float rate = (m_simulation->GetSimulatedTurnCount() - firstSimulatedTurnCount) * 1000.0f / elapsedMicroseconds;
+		if (m_simulatedTurnsPerMillisecond <= 0.0f) m_simulatedTurnsPerMillisecond = rate;
+		else m_simulatedTurnsPerMillisecond = LERP(m_simulatedTurnsPerMillisecond, rate, HORIZON_RATE_SMOOTHING);
+	}
+}
+
+// Share of the simulation budget matching a share of the time per turn, 0 when searching on the clock
+long long Solver::ComputeSimulationBudget(int _timeAllocated) const
+{
+	if (m_parameters.m_simulationBudget <= 0) return 0;
+	return max((long long)m_parameters.m_simulationBudget * _timeAllocated / max(m_parameters.m_timeAllocatedPerTurn, 1), 1LL);
+}
+
+const Solution& Solver::EndTurn()
+{
+	DEBUG_LOG << m_nbSolutionFound << " good solutions have been found for " << m_nbSolutionCreated << " created." << endl;
 
 	sort(m_solutions.begin(), m_solutions.end(), CompareByScore);
 
-	cerr << "Wining solution have a score of " << m_solutions[0].m_score << endl;
+	DEBUG_LOG << "Wining solution have a score of " << m_solutions[0].m_score << endl;
+	DEBUG_LOG << m_nbRolloutReused << " rollouts reused from the predicted state" << endl;
+	DEBUG_LOG << m_nbSolutionPruned << " candidates pruned, saving " << m_nbTurnPruned << " simulated turns" << endl;
+	DEBUG_LOG << m_nbSoftDeadlineStop << " searches given up at the soft deadline" << endl;
+	DEBUG_LOG << "Improvements by mutation operator :";
+	for (int iOperator = 0; iOperator < MUTATION_OPERATOR_COUNT; iOperator++)
+	{
+		DEBUG_LOG << " " << m_nbOperatorImproved[iOperator] << "/" << m_nbOperatorUsed[iOperator];
+	}
+	DEBUG_LOG << endl;
+	DEBUG_LOG << m_nbCacheHit << " duplicate genomes skipped (" << (m_nbCacheHit * 100 / max(m_nbSolutionCreated, 1)) << "% hit rate)" << endl;
+	DEBUG_LOG << "Horizon of " << m_nbTurnSimulated << " turns at " << (int)m_simulatedTurnsPerMillisecond << " simulated turns per ms" << endl;
+
+	m_playedMoves = m_solutions[0].m_turns[0].m_moves;
+	m_simulation->SetPrediction(m_solutions[0]);
 
 	return m_solutions[0];
 }
 
-void Solver::Mutate(Solution* _solution)
+void Solver::AdoptPopulation(const Solver& _solver)
+{
+	// Keep the best solutions found, they are evaluated again from the real state by BeginTurn
+	m_solutions = _solver.m_solutions;
+	m_nbTurnSimulated = _solver.m_nbTurnSimulated;
+	sort(m_solutions.begin(), m_solutions.end(), CompareByScore);
+	m_solutions.resize(m_parameters.m_solutionsCount);
+}
+
+// Returns false when the rollout was abandoned before its last turn
+bool Solver::SimulateCandidate(Solution* _solution, int _firstTurn)
 {
-	for (size_t iTurn = 0; iTurn < NB_TURN_SIMULATED; iTurn++)
+	// The turns before the first mutated one kept the snapshots of the parent
+	m_simulation->SimulateSolution(*_solution, _firstTurn, _firstTurn);
+	for (int iTurn = _firstTurn; iTurn < m_nbTurnSimulated; iTurn++)
 	{
-		for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+		if (_solution->m_nbMacroAction > 0) ExpandMacroAction(_solution, iTurn);
+		m_simulation->ContinueSolution(*_solution);
+
+		// The bound only holds for the evaluation of the racer, and follows the rollout of the first scenario only,
+		// so it is an upper bound of the aggregated score only when the worst scenario alone is kept
+		int nbTurnLeft = m_nbTurnSimulated - iTurn - 1;
+		if (nbTurnLeft > 0 && IsRacer() && ComputeAggregatedScenarioCount() == 1 && false == CanBeatScore(*m_simulation, nbTurnLeft, m_lastScore))
 		{
-			_solution->m_turns[iTurn].m_moves[iPod] = Solution::GenerateMove(m_simulation->m_pods[iPod]);
+			m_nbSolutionPruned++;
+			m_nbTurnPruned += nbTurnLeft;
+			return false;
 		}
 	}
+	return true;
 }
 
-int Solver::EvaluateSolution(Solution* _solution, const Simulation& _simulation)
+// Rollout of a solution, the moves of a macro-action genome are expanded on the way
+void Solver::SimulatePlan(Solution* _solution, int _nbTurnSimulated, int _firstTurn)
 {
-	int score = -1;
-
-	// Score the most ahead player pod
-	for (size_t iPod = 0; iPod < 1; iPod++)
+	if (_solution->m_nbMacroAction == 0)
 	{
-		const Pod& pod = _simulation.m_tempPods[iPod];
-		int distanceToCheckpoint = Vector2::SquareDistance(pod.m_position, _simulation.m_checkpoints[pod.m_currentCheckpointIndex].m_position) / 10000;
-		score += EVALUATION_CHECKPOINT_FACTOR * (pod.m_checkpointPassedCount + 1) - distanceToCheckpoint;
+		m_simulation->SimulateSolution(*_solution, _nbTurnSimulated, _firstTurn);
+		return;
 	}
 
-	_solution->m_score = score;
-	return score;
+	m_simulation->SimulateSolution(*_solution, _firstTurn, _firstTurn);
+	for (int iTurn = _firstTurn; iTurn < _nbTurnSimulated; iTurn++)
+	{
+		ExpandMacroAction(_solution, iTurn);
+		m_simulation->ContinueSolution(*_solution);
+	}
 }
 
-#pragma endregion
-
-int main()
+// The move of the turn steers to the point aimed by its action, from the pods the rollout reached
+void Solver::ExpandMacroAction(Solution* _solution, int _turn) const
 {
-	bool isFirstTurn = true;
+	int firstTurn = 0;
+	const MacroAction& action = _solution->m_macroActions[_solution->FindMacroAction(_turn, &firstTurn)];
+	const Pod& pod = m_simulation->m_tempPods[m_podIndex];
+
+	int checkpointIndex = (pod.m_currentCheckpointIndex + action.m_checkpointOffset) % m_simulation->m_checkpointCount_Lap;
+	const Vector2& checkpointPosition = m_simulation->m_checkpoints[checkpointIndex].m_position;
+	Vector2 podToCheckpoint = checkpointPosition - pod.m_position;
+	float distanceToCheckpoint = podToCheckpoint.Magnitude();
+	Vector2 target = checkpointPosition + pod.m_speed * TARGET_SPEED_OFFSET_MULTIPLIER;
+	if (distanceToCheckpoint > 0.0f) target += Vector2(-podToCheckpoint.m_y, podToCheckpoint.m_x) * ((float)action.m_aimOffset / distanceToCheckpoint);
+
+	Vector2 podToTarget = target - pod.m_position;
+	float targetAngle = RAD_TO_DEG(atan2(podToTarget.m_y, podToTarget.m_x));
+	float rotation = fmod(targetAngle - pod.m_angle + 540.0f, 360.0f) - 180.0f;
+
+	Move& move = _solution->m_turns[_turn].m_moves[m_podIndex];
+	move.m_rotation = (int)round(clamp(rotation, -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION));
+	move.m_useBoost = action.m_useBoost && _turn == firstTurn && false == pod.m_usedBoost;
+	move.m_useShield = false;
+	move.m_thrust = move.m_useBoost ? 0 : action.m_thrust;
+}
 
-	Simulation simulation;
-	Solver solver(&simulation);
+// Optimistic bound of the evaluation: the pod flies straight at full thrust along the checkpoints
+bool Solver::CanBeatScore(const Simulation& _simulation, int _nbTurnLeft, int _scoreToBeat) const
+{
+	const Pod& pod = _simulation.m_tempPods[0];
+	float reach = pod.ComputeReach(_nbTurnLeft, false == pod.m_usedBoost);
 
-	simulation.InitializeCheckpoints();
+	int checkpointIndex = pod.m_currentCheckpointIndex;
+	float distanceToCheckpoint = Vector2::Distance(pod.m_position, _simulation.m_checkpoints[checkpointIndex].m_position);
+	float reachLeft = reach;
+	float bestScore = MINIMUM_INT;
 
-	long long timeUsed = 0;
+	// A checkpoint can be passed at most every turn, each one passed is worth more than any distance
+	for (int iCheckpoint = 0; iCheckpoint <= _nbTurnLeft; iCheckpoint++)
+	{
+		float distanceLeft = max(distanceToCheckpoint - reachLeft, 0.0f);
+		float score = (float)m_parameters.m_evaluationCheckpointFactor * (pod.m_checkpointPassedCount + iCheckpoint + 1) - distanceLeft * distanceLeft / 10000.0f;
+		bestScore = max(bestScore, score);
+		if (bestScore > _scoreToBeat) return true;
+
+		reachLeft -= max(distanceToCheckpoint - CHECKPOINT_RADIUS, 0.0f);
+		if (reachLeft < 0.0f) break;
+
+		// The checkpoint is passed anywhere inside its radius
+		int nextCheckpointIndex = (checkpointIndex + 1) % _simulation.m_checkpointCount_Lap;
+		distanceToCheckpoint = Vector2::Distance(_simulation.m_checkpoints[checkpointIndex].m_position, _simulation.m_checkpoints[nextCheckpointIndex].m_position) - CHECKPOINT_RADIUS;
+		checkpointIndex = nextCheckpointIndex;
+	}
 
-	while (1)
+	// A bounce can push the pod further than its engine, nothing is pruned when one is possible
+	for (int iPod = 1; iPod < POD_TOTAL_NB; iPod++)
 	{
-		cerr << "Time used for last frame = " << timeUsed << endl;
-		auto startTime = high_resolution_clock::now();
+		const Pod& otherPod = _simulation.m_tempPods[iPod];
+		bool canOtherPodBoost = iPod < POD_NB_TO_SIMULATE && false == otherPod.m_usedBoost;
+		float contactDistance = reach + otherPod.ComputeReach(_nbTurnLeft, canOtherPodBoost) + POD_COLLIDER_SIZE + POD_COLLIDER_SIZE;
+		if (Vector2::SquareDistance(pod.m_position, otherPod.m_position) < contactDistance * contactDistance) return true;
+	}
 
-		simulation.ReceivePodsInputs(isFirstTurn);
-		const Solution& solution = solver.Solve();
-		simulation.SendOutputFromSolution(solution);
+	return false;
+}
 
-		isFirstTurn = false;
-		timeUsed = duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count();
+bool Solver::IsInEndgame() const
+{
+	return IsRacer() && m_simulation->m_checkpointCount_Race > 0 && m_simulation->m_pods[m_podIndex].m_checkpointPassedCount >= m_simulation->m_checkpointCount_Race - 1;
+}
+
+// Iterative deepening over a discrete set of moves, the first plan found is the one with the fewest turns
+bool Solver::SolveEndgame(int _timeAllocated)
+{
+	auto startTime = high_resolution_clock::now();
+	const Pod& pod = m_simulation->m_pods[m_podIndex];
+	float distanceToCross = Vector2::Distance(pod.m_position, m_simulation->m_checkpoints[pod.m_currentCheckpointIndex].m_position) - CHECKPOINT_RADIUS;
+
+	// Not tractable while the finish line is further than the deepest search can reach
+	int depth = 1;
+	while (depth <= ENDGAME_MAXIMUM_DEPTH && pod.ComputeReach(depth, false == pod.m_usedBoost) < distanceToCross) depth++;
+	if (depth > ENDGAME_MAXIMUM_DEPTH) return false;
+
+	m_endgameDeadline = startTime + milliseconds(_timeAllocated);
+	const long long simulationBudget = ComputeSimulationBudget(_timeAllocated);
+	m_endgameSimulationLimit = simulationBudget > 0 ? m_simulation->GetSimulatedTurnCount() + simulationBudget : 0;
+	m_isEndgameTimeOut = false;
+	m_nbEndgameNode = 0;
+
+	Solution solution;
+	ApplyPartnerMoves(&solution);
+	for (; depth <= ENDGAME_MAXIMUM_DEPTH; depth++)
+	{
+		m_simulation->m_tempPods = m_simulation->m_pods;
+		if (SearchEndgame(&solution, 0, depth)) break;
+		if (m_isEndgameTimeOut) break;
+	}
+
+	if (depth > ENDGAME_MAXIMUM_DEPTH || m_isEndgameTimeOut)
+	{
+		DEBUG_LOG << "Endgame search failed after " << m_nbEndgameNode << " nodes" << endl;
+		return false;
 	}
+
+	// Simulated again for the snapshots, the turns after the finish line do not matter
+	m_simulation->SimulateSolution(solution, depth);
+	solution.m_score = ENDGAME_SCORE - depth;
+	m_lastScore = solution.m_score;
+	m_solutions.push_back(solution);
+	m_nbSolutionFound++;
+	DEBUG_LOG << "Endgame solved in " << depth << " turns after " << m_nbEndgameNode << " nodes" << endl;
+	return true;
 }
+
+bool Solver::SearchEndgame(Solution* _solution, int _turn, int _depth)
+{
+	if ((++m_nbEndgameNode & 255) == 0)
+	{
+		if (m_endgameSimulationLimit > 0) m_isEndgameTimeOut = m_simulation->GetSimulatedTurnCount() >= m_endgameSimulationLimit;
+		else m_isEndgameTimeOut = high_resolution_clock::now() > m_endgameDeadline;
+	}
+	if (m_isEndgameTimeOut) return false;
+
+	const array<Pod, POD_TOTAL_NB> pods = m_simulation->m_tempPods;
+	const Pod& pod = pods[m_podIndex];
+	const Vector2& checkpointPosition = m_simulation->m_checkpoints[pod.m_currentCheckpointIndex].m_position;
+	const int nbTurnLeft = _depth - _turn - 1;
+
+	// Rotations closest to the checkpoint are tried first
+	Vector2 podToCheckpoint = checkpointPosition - pod.m_position;
+	float checkpointAngle = RAD_TO_DEG(atan2(podToCheckpoint.m_y, podToCheckpoint.m_x));
+	int idealRotation = (int)round(clamp(fmod(checkpointAngle - pod.m_angle + 540.0f, 360.0f) - 180.0f, -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION));
+	array<int, 5> rotations = { idealRotation, idealRotation - ENDGAME_ROTATION_STEP, idealRotation + ENDGAME_ROTATION_STEP, idealRotation - 2 * ENDGAME_ROTATION_STEP, idealRotation + 2 * ENDGAME_ROTATION_STEP };
+	const array<int, 4> thrusts = { POD_BOOST_ACCELERATION, POD_MAX_THRUST, POD_MAX_THRUST / 2, 0 };
+
+	for (int rotation : rotations)
+	{
+		if (abs(rotation) > (int)POD_MAXIMUM_ROTATION) continue;
+		for (int thrust : thrusts)
+		{
+			Move& move = _solution->m_turns[_turn].m_moves[m_podIndex];
+			move.m_rotation = rotation;
+			move.m_useBoost = thrust == POD_BOOST_ACCELERATION;
+			move.m_thrust = move.m_useBoost ? 0 : thrust;
+			if (move.m_useBoost && pod.m_usedBoost) continue;
+
+			m_simulation->m_tempPods = pods;
+			m_simulation->SimulateTurn(_solution->m_turns[_turn].m_moves);
+			const Pod& nextPod = m_simulation->m_tempPods[m_podIndex];
+			if (nextPod.m_checkpointPassedCount > pod.m_checkpointPassedCount) return true;
+			if (nbTurnLeft == 0) continue;
+
+			// Cut the branches that cannot reach the checkpoint anymore
+			float distanceToCross = Vector2::Distance(nextPod.m_position, checkpointPosition) - CHECKPOINT_RADIUS;
+			if (nextPod.ComputeReach(nbTurnLeft, false == nextPod.m_usedBoost) < distanceToCross) continue;
+
+			if (SearchEndgame(_solution, _turn + 1, _depth)) return true;
+		}
+	}
+	return false;
+}
+
+int Solver::SelectMutationOperator() const
+{
+	const bool canBoost = m_simulation->m_pods[m_podIndex].CanBoost();
+	float logTotalPulls = log(max(m_operatorTotalPulls, 1.0f));
+
+	int bestOperator = MUTATION_REGENERATE;
+	float bestValue = -1.0f;
+	for (int iOperator = 0; iOperator < MUTATION_OPERATOR_COUNT; iOperator++)
+	{
+		if (iOperator == MUTATION_TOGGLE_BOOST && false == canBoost) continue;
+		if (iOperator == MUTATION_TOGGLE_SHIELD && IsRacer()) continue;
+
+		// Every operator is tried before the statistics are trusted
+		if (m_operatorPulls[iOperator] < 1.0f) return iOperator;
+
+		float mean = m_operatorRewards[iOperator] / m_operatorPulls[iOperator];
+		float value = mean + MUTATION_BANDIT_EXPLORATION * sqrt(logTotalPulls / m_operatorPulls[iOperator]);
+		if (value > bestValue)
+		{
+			bestValue = value;
+			bestOperator = iOperator;
+		}
+	}
+	return bestOperator;
+}
+
+void Solver::RewardMutationOperator(int _operator, bool _hasImproved)
+{
+	for (int iOperator = 0; iOperator < MUTATION_OPERATOR_COUNT; iOperator++)
+	{
+		m_operatorPulls[iOperator] *= MUTATION_BANDIT_DECAY;
+		m_operatorRewards[iOperator] *= MUTATION_BANDIT_DECAY;
+	}
+	m_operatorTotalPulls = m_operatorTotalPulls * MUTATION_BANDIT_DECAY + 1.0f;
+	m_operatorPulls[_operator] += 1.0f;
+	if (_hasImproved) m_operatorRewards[_operator] += 1.0f;
+}
+
+// Returns the first turn changed, the rollout of the parent stays valid before it
+int Solver::Mutate(Solution* _solution, int _operator)
+{
+	if (_solution->m_nbMacroAction > 0) return MutateMacroActions(_solution, _operator);
+
+	const int lastTurn = m_nbTurnSimulated - 1;
+	const int turn = Random::Range(0, m_nbTurnSimulated);
+	const int iPod = m_podIndex;
+	Move& move = _solution->m_turns[turn].m_moves[iPod];
+	int firstTurn = turn;
+
+	switch (_operator)
+	{
+	case MUTATION_ROTATION_NUDGE:
+		move.m_rotation = clamp(move.m_rotation + Random::Range(-MUTATION_ROTATION_NUDGE_SIZE, MUTATION_ROTATION_NUDGE_SIZE + 1), (int)-POD_MAXIMUM_ROTATION, (int)POD_MAXIMUM_ROTATION);
+		break;
+
+	case MUTATION_THRUST_NUDGE:
+		if (move.m_useBoost || move.m_useShield)
+		{
+			move.m_useBoost = false;
+			move.m_useShield = false;
+			move.m_thrust = POD_MAX_THRUST;
+		}
+		move.m_thrust = clamp(move.m_thrust + Random::Range(-MUTATION_THRUST_NUDGE_SIZE, MUTATION_THRUST_NUDGE_SIZE + 1), 0, POD_MAX_THRUST);
+		break;
+
+	case MUTATION_TOGGLE_BOOST:
+		// Only the first boost of the plan does something, the others are removed
+		for (int iTurn = 0; iTurn < m_nbTurnSimulated; iTurn++)
+		{
+			Move& otherMove = _solution->m_turns[iTurn].m_moves[iPod];
+			if (iTurn == turn || false == otherMove.m_useBoost) continue;
+			otherMove.m_useBoost = false;
+			otherMove.m_thrust = POD_MAX_THRUST;
+			firstTurn = min(firstTurn, iTurn);
+		}
+		move.m_useBoost = false == move.m_useBoost;
+		move.m_useShield = false;
+		move.m_thrust = move.m_useBoost ? 0 : POD_MAX_THRUST;
+		break;
+
+	case MUTATION_TOGGLE_SHIELD:
+		move.m_useShield = false == move.m_useShield;
+		move.m_useBoost = false;
+		move.m_thrust = move.m_useShield ? 0 : POD_MAX_THRUST;
+		break;
+
+	case MUTATION_SHIFT_TURN:
+		// Only the moves of the searched pod are shifted, the partner plan stays in place
+		if (Random::Range(0, 2) == 0)
+		{
+			// Later : the move of the turn is played twice
+			for (int iTurn = lastTurn; iTurn > turn; iTurn--) _solution->m_turns[iTurn].m_moves[iPod] = _solution->m_turns[iTurn - 1].m_moves[iPod];
+		}
+		else
+		{
+			// Earlier : the move of the turn is skipped
+			for (int iTurn = turn; iTurn < lastTurn; iTurn++) _solution->m_turns[iTurn].m_moves[iPod] = _solution->m_turns[iTurn + 1].m_moves[iPod];
+			_solution->m_turns[lastTurn].m_moves[iPod] = Solution::GenerateMove(m_simulation->m_pods[iPod], m_parameters);
+		}
+		break;
+
+	case MUTATION_COPY_FROM_ELITE:
+		for (int iTurn = turn; iTurn < m_nbTurnSimulated; iTurn++)
+		{
+			_solution->m_turns[iTurn] = m_solutions[m_bestSolutionIndex].m_turns[iTurn];
+		}
+		break;
+
+	case MUTATION_HEURISTIC_INJECTION:
+		// Simulated on the way, the candidate rollout has nothing left to do
+		HeuristicPolicy::Rollout(m_simulation, _solution, m_nbTurnSimulated, min(turn, _solution->m_nbTurnSimulated), iPod);
+		firstTurn = m_nbTurnSimulated;
+		break;
+
+	default:
+		for (int iTurn = 0; iTurn < m_nbTurnSimulated; iTurn++)
+		{
+			_solution->m_turns[iTurn].m_moves[iPod] = Solution::GenerateMove(m_simulation->m_pods[iPod], m_parameters);
+		}
+		firstTurn = 0;
+		break;
+	}
+
+	// The snapshots of the parent are only valid up to the turns it simulated
+	return min(firstTurn, _solution->m_nbTurnSimulated);
+}
+
+// The operators of the moves applied to one action, returns the first turn whose move may change
+int Solver::MutateMacroActions(Solution* _solution, int _operator)
+{
+	const int actionIndex = Random::Range(0, _solution->m_nbMacroAction);
+	MacroAction& action = _solution->m_macroActions[actionIndex];
+	int firstTurn = 0;
+	for (int iAction = 0; iAction < actionIndex; iAction++) firstTurn += _solution->m_macroActions[iAction].m_nbTurn;
+
+	switch (_operator)
+	{
+	case MUTATION_ROTATION_NUDGE:
+		if (Random::Range(0, 100) < MACRO_ACTION_PROBABILITY_TO_AIM_NEXT) action.m_checkpointOffset = 1 - action.m_checkpointOffset;
+		else action.m_aimOffset = clamp(action.m_aimOffset + Random::Range(-MACRO_ACTION_AIM_NUDGE_SIZE, MACRO_ACTION_AIM_NUDGE_SIZE + 1), -MACRO_ACTION_MAXIMUM_AIM_OFFSET, MACRO_ACTION_MAXIMUM_AIM_OFFSET);
+		break;
+
+	case MUTATION_THRUST_NUDGE:
+		action.m_thrust = clamp(action.m_thrust + Random::Range(-MUTATION_THRUST_NUDGE_SIZE, MUTATION_THRUST_NUDGE_SIZE + 1), 0, POD_MAX_THRUST);
+		break;
+
+	case MUTATION_TOGGLE_BOOST:
+		// Only one action of the plan boosts
+		for (int iAction = 0; iAction < _solution->m_nbMacroAction; iAction++)
+		{
+			MacroAction& otherAction = _solution->m_macroActions[iAction];
+			if (iAction == actionIndex || false == otherAction.m_useBoost) continue;
+			otherAction.m_useBoost = false;
+			firstTurn = 0;
+		}
+		action.m_useBoost = false == action.m_useBoost;
+		break;
+
+	case MUTATION_SHIFT_TURN:
+		// A turn moves between the action and the next one, the last action is split in two
+		if (actionIndex + 1 < _solution->m_nbMacroAction)
+		{
+			MacroAction& nextAction = _solution->m_macroActions[actionIndex + 1];
+			if (Random::Range(0, 2) == 0 && action.m_nbTurn > 1)
+			{
+				action.m_nbTurn--;
+				nextAction.m_nbTurn++;
+			}
+			else if (nextAction.m_nbTurn > 1)
+			{
+				action.m_nbTurn++;
+				nextAction.m_nbTurn--;
+			}
+		}
+		else if (_solution->m_nbMacroAction < MACRO_ACTION_MAX_NB && action.m_nbTurn > 1)
+		{
+			MacroAction& newAction = _solution->m_macroActions[_solution->m_nbMacroAction++];
+			newAction = action;
+			newAction.m_useBoost = false;
+			newAction.m_nbTurn = Random::Range(1, action.m_nbTurn);
+			action.m_nbTurn -= newAction.m_nbTurn;
+		}
+		break;
+
+	case MUTATION_COPY_FROM_ELITE:
+	{
+		const Solution& bestSolution = m_solutions[m_bestSolutionIndex];
+		if (bestSolution.m_nbMacroAction <= actionIndex) break;
+		for (int iAction = actionIndex; iAction < bestSolution.m_nbMacroAction; iAction++) _solution->m_macroActions[iAction] = bestSolution.m_macroActions[iAction];
+		_solution->m_nbMacroAction = bestSolution.m_nbMacroAction;
+		_solution->FitMacroActions(m_nbTurnSimulated);
+		break;
+	}
+
+	case MUTATION_HEURISTIC_INJECTION:
+		// The end of the plan goes straight at the checkpoint
+		action = MacroAction();
+		_solution->m_nbMacroAction = actionIndex + 1;
+		_solution->FitMacroActions(m_nbTurnSimulated);
+		break;
+
+	default:
+		_solution->GenerateMacroActions(m_simulation->m_pods[m_podIndex], m_parameters, m_nbTurnSimulated);
+		firstTurn = 0;
+		break;
+	}
+
+	// The snapshots of the parent are only valid up to the turns it simulated
+	return min(firstTurn, _solution->m_nbTurnSimulated);
+}
+
+// Returns the first turn where the partner moves of the solution changed
+int Solver::ApplyPartnerMoves(Solution* _solution) const
+{
+	int firstTurnChanged = NB_TURN_SIMULATED_MAX;
+	for (int iTurn = NB_TURN_SIMULATED_MAX - 1; iTurn >= 0; iTurn--)
+	{
+		Move& move = _solution->m_turns[iTurn].m_moves[m_partnerIndex];
+		if (move == m_partnerMoves[iTurn]) continue;
+		move = m_partnerMoves[iTurn];
+		firstTurnChanged = iTurn;
+	}
+	return firstTurnChanged;
+}
+
+void Solver::SetPartnerPlan(const Solution& _solution, int _firstTurn)
+{
+	// The last move of the plan is repeated beyond its horizon
+	const int lastTurn = max(_solution.m_nbTurnSimulated - 1, 0);
+	for (int iTurn = 0; iTurn < NB_TURN_SIMULATED_MAX; iTurn++)
+	{
+		m_partnerMoves[iTurn] = _solution.m_turns[min(_firstTurn + iTurn, lastTurn)].m_moves[m_partnerIndex];
+	}
+}
+
+int Solver::EvaluateSolution(Solution* _solution, const Simulation& _simulation)
+{
+	int score = EvaluatePods(_simulation.m_tempPods, _simulation);
+	if (m_parameters.m_scenarioCount > 1) score = EvaluateScenarios(*_solution, score);
+	_solution->m_score = score;
+	return score;
+}
+
+int Solver::EvaluatePods(const array<Pod, POD_TOTAL_NB>& _pods, const Simulation& _simulation) const
+{
+	int score = -1;
+
+	// Score the most ahead player pod
+	for (size_t iPod = 0; iPod < 1; iPod++)
+	{
+		const Pod& pod = _pods[iPod];
+		int distanceToCheckpoint = Vector2::SquareDistance(pod.m_position, _simulation.m_checkpoints[pod.m_currentCheckpointIndex].m_position) / 10000;
+		score += m_parameters.m_evaluationCheckpointFactor * (pod.m_checkpointPassedCount + 1) - distanceToCheckpoint;
+	}
+
+	// The blocker keeps the score of the racer and removes the one of the opponent it harasses,
+	// while staying on the way of the opponent to its next checkpoint
+	if (false == IsRacer())
+	{
+		const Pod& target = _pods[m_targetPodIndex];
+		const Vector2& targetCheckpointPosition = _simulation.m_checkpoints[target.m_currentCheckpointIndex].m_position;
+		int targetDistanceToCheckpoint = Vector2::SquareDistance(target.m_position, targetCheckpointPosition) / 10000;
+		int guardDistance = (int)Vector2::Distance(_pods[m_podIndex].m_position, targetCheckpointPosition) / BLOCKER_GUARD_DIVIDER;
+		score -= m_parameters.m_evaluationCheckpointFactor * (target.m_checkpointPassedCount + 1) - targetDistanceToCheckpoint + guardDistance;
+
+		// Positive like the score of the racer, so the comparisons with the initial score still hold
+		score += m_parameters.m_evaluationCheckpointFactor * (_simulation.m_checkpointCount_Race + 1);
+	}
+
+	return score;
+}
+
+// The other scenarios are played from the rollout of the first one, the last pods of the rollout are put back afterwards
+int Solver::EvaluateScenarios(const Solution& _solution, int _firstScenarioScore)
+{
+	const array<Pod, POD_TOTAL_NB> lastPods = m_simulation->m_tempPods;
+	const int scenarioCount = min(m_parameters.m_scenarioCount, (int)OPPONENT_SCENARIO_COUNT);
+	array<int, OPPONENT_SCENARIO_COUNT> scores;
+	scores.fill(numeric_limits<int>::max()); // Scenarios not played are sorted last
+	scores[0] = _firstScenarioScore;
+	for (int iScenario = 1; iScenario < scenarioCount; iScenario++)
+	{
+		m_simulation->SimulateScenario(_solution, iScenario);
+		scores[iScenario] = EvaluatePods(m_simulation->m_tempPods, *m_simulation);
+	}
+	m_simulation->m_tempPods = lastPods;
+
+	sort(scores.begin(), scores.end());
+	const int aggregatedCount = ComputeAggregatedScenarioCount();
+	long long sum = 0;
+	for (int iScenario = 0; iScenario < aggregatedCount; iScenario++) sum += scores[iScenario];
+	return (int)(sum / aggregatedCount);
+}
+
+// Number of the worst scenario scores averaged into the evaluation
+int Solver::ComputeAggregatedScenarioCount() const
+{
+	const int scenarioCount = min(m_parameters.m_scenarioCount, (int)OPPONENT_SCENARIO_COUNT);
+	if (m_parameters.m_scenarioAggregation == SCENARIO_AGGREGATION_WORST) return 1;
+	if (m_parameters.m_scenarioAggregation == SCENARIO_AGGREGATION_CVAR) return max(scenarioCount * SCENARIO_CVAR_SHARE / 100, 1);
+	return max(scenarioCount, 1);
+}
+
+#pragma endregion
+
+#pragma region Map Analysis Class
+
+// Spends the larger budget of the first turn on the map : boost checkpoint, racing line and opening moves
+class MapAnalysis
+{
+public:
+
+	static void Analyze(Simulation* _simulation, Solver* _solver);
+	static int ComputeHeuristicLapTurns(Simulation _simulation);
+
+private:
+
+	static Simulation CreateSoloSimulation(const Simulation& _simulation);
+};
+
+void MapAnalysis::Analyze(Simulation* _simulation, Solver* _solver)
+{
+	auto startTime = high_resolution_clock::now();
+	const SearchParameters& parameters = _solver->GetParameters();
+	Simulation soloSimulation = CreateSoloSimulation(*_simulation);
+
+	// The boost is kept for the checkpoint that gives the fastest heuristic lap, the one of a known map was found offline
+	int boostCheckpointIndex = _simulation->m_knownMapIndex >= 0 ? _simulation->m_knownBoostCheckpointIndex : -1;
+	soloSimulation.m_pods[0].m_boostCheckpointIndex = boostCheckpointIndex;
+	int bestLapTurns = ComputeHeuristicLapTurns(soloSimulation);
+	for (int iCheckpoint = 0; iCheckpoint < soloSimulation.m_checkpointCount_Lap && _simulation->m_knownMapIndex < 0; iCheckpoint++)
+	{
+		soloSimulation.m_pods[0].m_boostCheckpointIndex = iCheckpoint;
+		int lapTurns = ComputeHeuristicLapTurns(soloSimulation);
+		if (lapTurns < bestLapTurns)
+		{
+			bestLapTurns = lapTurns;
+			boostCheckpointIndex = iCheckpoint;
+		}
+	}
+	soloSimulation.m_pods[0].m_boostCheckpointIndex = boostCheckpointIndex;
+	_simulation->m_pods[RACER_POD_INDEX].m_boostCheckpointIndex = boostCheckpointIndex;
+
+	// Race one lap alone with the search, spreading the remaining time over the expected turns
+	Solver soloSolver(&soloSimulation, parameters);
+	vector<Turn> openingTurns;
+	array<Vector2, CHECKPOINT_MAX_NB> racingLine;
+	const int lapPassedCount = soloSimulation.m_pods[0].m_checkpointPassedCount + soloSimulation.m_checkpointCount_Lap;
+	// On a simulation budget the clock is ignored and every turn of the lap gets its share
+	const bool isOnClock = parameters.m_simulationBudget <= 0;
+	int timePassed = isOnClock ? (int)duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count() : 0;
+	const int timePerTurn = max((parameters.m_mapAnalysisTime - timePassed) / max(bestLapTurns, 1), 1);
+	int lapTurns = 0;
+	while (soloSimulation.m_pods[0].m_checkpointPassedCount < lapPassedCount && lapTurns < MAP_ANALYSIS_MAXIMUM_TURNS)
+	{
+		timePassed = isOnClock ? (int)duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count() : 0;
+		if (isOnClock && timePassed + timePerTurn > parameters.m_mapAnalysisTime) break;
+
+		soloSolver.BeginTurn();
+		soloSolver.Search(timePerTurn);
+		const Solution& solution = soloSolver.EndTurn();
+		if ((int)openingTurns.size() < OPENING_BOOK_TURNS) openingTurns.push_back(solution.m_turns[0]);
+
+		int checkpointIndex = soloSimulation.m_pods[0].m_currentCheckpointIndex;
+		soloSimulation.m_tempPods = soloSimulation.m_pods;
+		soloSimulation.SimulateTurn(solution.m_turns[0].m_moves);
+		soloSimulation.m_pods = soloSimulation.m_tempPods;
+		soloSimulation.m_turn++;
+		if (soloSimulation.m_pods[0].m_currentCheckpointIndex != checkpointIndex) racingLine[checkpointIndex] = soloSimulation.m_pods[0].m_position;
+		lapTurns++;
+	}
+	_solver->SetOpening(openingTurns);
+
+	// The racing line is only kept if the heuristic gets faster by following it, the one of a known map is better already
+	if (_simulation->m_knownMapIndex < 0 && soloSimulation.m_pods[0].m_checkpointPassedCount >= lapPassedCount)
+	{
+		Simulation racingLineSimulation = CreateSoloSimulation(*_simulation);
+		racingLineSimulation.m_racingLine = racingLine;
+		racingLineSimulation.m_hasRacingLine = true;
+		int racingLineLapTurns = ComputeHeuristicLapTurns(racingLineSimulation);
+		if (racingLineLapTurns < bestLapTurns)
+		{
+			_simulation->m_racingLine = racingLine;
+			_simulation->m_hasRacingLine = true;
+		}
+		DEBUG_LOG << "Racing line found with a heuristic lap in " << racingLineLapTurns << " turns" << endl;
+	}
+
+	DEBUG_LOG << "Map analysis : boost kept for checkpoint " << boostCheckpointIndex << ", heuristic lap in " << bestLapTurns << " turns, searched lap in " << lapTurns
+		<< " turns, " << openingTurns.size() << " opening turns" << endl;
+}
+
+// Copy of the simulation where the other pods are out of the way
+Simulation MapAnalysis::CreateSoloSimulation(const Simulation& _simulation)
+{
+	Simulation soloSimulation = _simulation;
+	for (int iPod = 1; iPod < POD_TOTAL_NB; iPod++)
+	{
+		soloSimulation.m_pods[iPod].m_position = Vector2(-MAP_WIDTH * iPod, -MAP_HEIGHT * iPod);
+		soloSimulation.m_pods[iPod].m_speed = Vector2::Zero;
+	}
+	return soloSimulation;
+}
+
+int MapAnalysis::ComputeHeuristicLapTurns(Simulation _simulation)
+{
+	const int lapPassedCount = _simulation.m_pods[0].m_checkpointPassedCount + _simulation.m_checkpointCount_Lap;
+	_simulation.m_tempPods = _simulation.m_pods;
+	for (int iTurn = 0; iTurn < MAP_ANALYSIS_MAXIMUM_TURNS; iTurn++)
+	{
+		// The other controlled pod coasts out of the way
+		array<Move, POD_NB_TO_SIMULATE> moves;
+		moves[RACER_POD_INDEX] = HeuristicPolicy::ComputeMove(_simulation.m_tempPods[RACER_POD_INDEX], _simulation);
+		_simulation.SimulateTurn(moves);
+		if (_simulation.m_tempPods[0].m_checkpointPassedCount >= lapPassedCount) return iTurn + 1;
+	}
+	return MAP_ANALYSIS_MAXIMUM_TURNS;
+}
+
+#pragma endregion
+
+#pragma region Pod Scheduler Class
+
+// Splits each turn between the search of the racer and the one of the blocker, the share changes with the race
+class PodScheduler
+{
+public:
+
+	PodScheduler(Simulation* _simulation, const SearchParameters& _parameters = SearchParameters());
+
+	array<PodOutput, POD_CONTROLLABLE_NB> Solve(const array<PodOutput, POD_CONTROLLABLE_NB>& _fallbackOutputs);
+	array<PodOutput, POD_CONTROLLABLE_NB> Solve(int _timeAllocated, bool _isRacerPopulationShifted, const array<PodOutput, POD_CONTROLLABLE_NB>& _fallbackOutputs);
+	Solver& GetRacer() { return m_racer; }
+	int GetBelowHeuristicCount() const { return m_nbBelowHeuristic; }
+
+private:
+
+	int ComputeBlockerShare() const;
+
+	Simulation* m_simulation = nullptr;
+	SearchParameters m_parameters;
+	Solver m_racer;
+	Solver m_blocker;
+	Solution m_blockerSolution; // Plan of the blocker chosen last turn, followed by the racer search
+	int m_nbBelowHeuristic = 0;
+};
+
+PodScheduler::PodScheduler(Simulation* _simulation, const SearchParameters& _parameters)
+	: m_simulation(_simulation), m_parameters(_parameters), m_racer(_simulation, _parameters, RACER_POD_INDEX), m_blocker(_simulation, _parameters, BLOCKER_POD_INDEX)
+{
+}
+
+array<PodOutput, POD_CONTROLLABLE_NB> PodScheduler::Solve(const array<PodOutput, POD_CONTROLLABLE_NB>& _fallbackOutputs)
+{
+	return Solve(m_parameters.m_timeAllocatedPerTurn, false, _fallbackOutputs);
+}
+
+array<PodOutput, POD_CONTROLLABLE_NB> PodScheduler::Solve(int _timeAllocated, bool _isRacerPopulationShifted, const array<PodOutput, POD_CONTROLLABLE_NB>& _fallbackOutputs)
+{
+	auto startTime = high_resolution_clock::now();
+	const int blockerShare = ComputeBlockerShare();
+
+	// The racer follows what the blocker planned last turn, then the blocker searches around the new plan of the racer
+	m_racer.SetPartnerPlan(m_blockerSolution, 1);
+	m_racer.BeginTurn(_isRacerPopulationShifted);
+	m_racer.Search(_timeAllocated * (100 - blockerShare) / 100);
+	const Solution& racerSolution = m_racer.EndTurn();
+
+	m_blocker.SetPartnerPlan(racerSolution, 0);
+	m_blocker.BeginTurn();
+	// On a simulation budget the blocker gets its share instead of what the clock left
+	int timePassed = (int)duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count();
+	if (m_parameters.m_simulationBudget > 0) timePassed = _timeAllocated * (100 - blockerShare) / 100;
+	m_blocker.Search(max(_timeAllocated - timePassed, 0));
+	m_blockerSolution = m_blocker.EndTurn();
+
+	// Both searches set the prediction, the one of the blocker holds the moves actually played
+	m_racer.SetPlayedMoves(m_blockerSolution.m_turns[0].m_moves);
+	DEBUG_LOG << "Blocker share of " << blockerShare << "%" << endl;
+
+	// Each pod falls back to its heuristic on its own
+	array<PodOutput, POD_CONTROLLABLE_NB> outputs = m_simulation->ComputeOutputsFromSolution(m_blockerSolution);
+	if (false == m_racer.HasBeatenHeuristic())
+	{
+		outputs[RACER_POD_INDEX] = _fallbackOutputs[RACER_POD_INDEX];
+		m_nbBelowHeuristic++;
+	}
+	if (false == m_blocker.HasBeatenHeuristic()) outputs[BLOCKER_POD_INDEX] = _fallbackOutputs[BLOCKER_POD_INDEX];
+	return outputs;
+}
+
+int PodScheduler::ComputeBlockerShare() const
+{
+	if (m_racer.IsInEndgame()) return BLOCKER_TIME_SHARE_ENDGAME;
+
+	// An opponent ahead of the racer is where the blocker makes the difference
+	const array<Pod, POD_TOTAL_NB>& pods = m_simulation->m_pods;
+	const Pod& racer = pods[RACER_POD_INDEX];
+	const Pod& leader = pods[m_simulation->FindEnemyLeader(pods)];
+	bool isBehind = leader.m_checkpointPassedCount > racer.m_checkpointPassedCount
+		|| (leader.m_checkpointPassedCount == racer.m_checkpointPassedCount
+			&& Vector2::SquareDistance(leader.m_position, m_simulation->m_checkpoints[leader.m_currentCheckpointIndex].m_position)
+			< Vector2::SquareDistance(racer.m_position, m_simulation->m_checkpoints[racer.m_currentCheckpointIndex].m_position));
+	return isBehind ? BLOCKER_TIME_SHARE_BEHIND : BLOCKER_TIME_SHARE;
+}
+
+#pragma endregion
+
+#pragma region Ponderer Class
+
+// Keeps searching on the predicted next state while the main thread waits for the referee
+class Ponderer
+{
+public:
+
+	~Ponderer();
+
+	void Start(const Simulation& _simulation, const Solver& _solver);
+	bool Stop(Solver* _solver, const Simulation& _simulation);
+	void Cancel(); // Stops without keeping anything, the pondered state belongs to another game
+
+private:
+
+	void Ponder();
+
+	thread m_thread;
+	atomic<bool> m_shouldStop = false;
+	Simulation m_simulation;
+	Solver m_solver = Solver(&m_simulation);
+	unsigned int m_seed = 0;
+};
+
+Ponderer::~Ponderer()
+{
+	m_shouldStop = true;
+	if (m_thread.joinable()) m_thread.join();
+}
+
+void Ponderer::Start(const Simulation& _simulation, const Solver& _solver)
+{
+	m_simulation = _simulation;
+	m_simulation.LoadPrediction();
+	m_solver = _solver;
+	m_solver.SetSimulation(&m_simulation);
+	m_seed = (unsigned int)Random::Range(0, MAXIMUM_INT);
+
+	m_shouldStop = false;
+	m_thread = thread(&Ponderer::Ponder, this);
+}
+
+bool Ponderer::Stop(Solver* _solver, const Simulation& _simulation)
+{
+	if (false == m_thread.joinable()) return false;
+
+	m_shouldStop = true;
+	m_thread.join();
+
+	// The work done on the predicted state is only worth keeping if the real state is the predicted one
+	bool isKept = _simulation.MatchesPrediction();
+	if (isKept) _solver->AdoptPopulation(m_solver);
+	DEBUG_LOG << "Ponder " << (isKept ? "kept" : "discarded") << " after " << m_solver.GetSolutionCreatedCount() << " solutions created" << endl;
+	return isKept;
+}
+
+void Ponderer::Cancel()
+{
+	m_shouldStop = true;
+	if (m_thread.joinable()) m_thread.join();
+}
+
+void Ponderer::Ponder()
+{
+	Random::SetSeed(m_seed);
+	m_solver.BeginTurn();
+	m_solver.Search(PONDER_MAXIMUM_TIME, &m_shouldStop);
+}
+
+#pragma endregion
+
+#pragma region Watchdog Class
+
+// Sends the fallback outputs itself if the main thread did not send anything before the deadline
+class Watchdog
+{
+public:
+
+	Watchdog(ostream& _stream = cout);
+	~Watchdog();
+
+	void Arm(int _deadline, const array<PodOutput, POD_CONTROLLABLE_NB>& _fallbackOutputs);
+	bool Claim(); // False when the fallback outputs have already been sent for this turn
+	int GetFallbackSentCount() const { return m_nbFallbackSent; }
+
+private:
+
+	void Watch();
+
+	thread m_thread;
+	ostream* m_stream = nullptr;
+	mutex m_mutex;
+	condition_variable m_condition;
+	bool m_isRunning = true;
+	bool m_isArmed = false;
+	high_resolution_clock::time_point m_deadline;
+	array<PodOutput, POD_CONTROLLABLE_NB> m_fallbackOutputs;
+	atomic<bool> m_isOutputSent = false;
+	atomic<int> m_nbFallbackSent = 0;
+};
+
+Watchdog::Watchdog(ostream& _stream)
+{
+	m_stream = &_stream;
+	m_thread = thread(&Watchdog::Watch, this);
+}
+
+Watchdog::~Watchdog()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_isRunning = false;
+	}
+	m_condition.notify_one();
+	m_thread.join();
+}
+
+void Watchdog::Arm(int _deadline, const array<PodOutput, POD_CONTROLLABLE_NB>& _fallbackOutputs)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_deadline = high_resolution_clock::now() + milliseconds(_deadline);
+		m_fallbackOutputs = _fallbackOutputs;
+		m_isOutputSent = false;
+		m_isArmed = true;
+	}
+	m_condition.notify_one();
+}
+
+bool Watchdog::Claim()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_isArmed = false;
+	return false == m_isOutputSent.exchange(true);
+}
+
+void Watchdog::Watch()
+{
+	unique_lock<mutex> lock(m_mutex);
+	while (m_isRunning)
+	{
+		if (false == m_isArmed)
+		{
+			m_condition.wait(lock);
+			continue;
+		}
+
+		m_condition.wait_until(lock, m_deadline);
+		if (false == m_isArmed || high_resolution_clock::now() < m_deadline) continue;
+
+		m_isArmed = false;
+		if (m_isOutputSent.exchange(true)) continue;
+		WriteOutputs(*m_stream, m_fallbackOutputs);
+		m_nbFallbackSent++;
+		DEBUG_LOG << "Watchdog sent the fallback outputs" << endl;
+	}
+}
+
+#pragma endregion
+
+#pragma region Gold Bot Class
+
+// The whole bot behind an init/step interface on plain structures, main only adapts it to the referee streams
+class GoldBot
+{
+public:
+
+	GoldBot(const SearchParameters& _parameters = SearchParameters());
+
+	void Init(const MapInput& _mapInput);
+	array<PodOutput, POD_CONTROLLABLE_NB> Step(const TurnInput& _turnInput, Watchdog* _watchdog = nullptr);
+	void Ponder(); // Searches the predicted next turn until the next step
+	bool HasWatchdogAnswered() const { return m_hasWatchdogAnswered; } // The fallback outputs were sent instead of the returned ones
+	float GetSimulatedTurnsPerMillisecond() const { return m_searchMicroseconds > 0 ? m_nbSimulatedTurn * 1000.0f / m_searchMicroseconds : 0.0f; }
+
+private:
+
+	SearchParameters m_parameters;
+	Simulation m_simulation;
+	PodScheduler m_scheduler;
+	Ponderer m_ponderer;
+	bool m_isFirstTurn = true;
+	bool m_hasWatchdogAnswered = false;
+	int m_nbTurn = 0;
+	long long m_nbSimulatedTurn = 0; // Whole game, for the effective simulation rate
+	long long m_searchMicroseconds = 0;
+};
+
+GoldBot::GoldBot(const SearchParameters& _parameters)
+	: m_parameters(_parameters), m_scheduler(&m_simulation, _parameters)
+{
+}
+
+// Everything learned during a previous game is dropped, pods, searches and map analysis
+void GoldBot::Init(const MapInput& _mapInput)
+{
+	m_ponderer.Cancel();
+	m_simulation = Simulation();
+	m_scheduler = PodScheduler(&m_simulation, m_parameters);
+	m_simulation.InitializeCheckpoints(_mapInput.m_numberOfLaps, _mapInput.m_checkpoints);
+	m_isFirstTurn = true;
+	m_hasWatchdogAnswered = false;
+	m_nbTurn = 0;
+	m_nbSimulatedTurn = 0;
+	m_searchMicroseconds = 0;
+}
+
+array<PodOutput, POD_CONTROLLABLE_NB> GoldBot::Step(const TurnInput& _turnInput, Watchdog* _watchdog)
+{
+	auto startTime = high_resolution_clock::now();
+	const long long firstSimulatedTurnCount = m_simulation.GetSimulatedTurnCount();
+
+	// A fixed seed per turn, so a turn replays the same whatever happened to the previous searches
+	const bool isDeterministic = m_parameters.m_simulationBudget > 0;
+	if (isDeterministic) Random::SetSeed(m_parameters.m_seed + (unsigned int)m_nbTurn * 7919u);
+
+	m_simulation.ApplyPodsInputs(_turnInput.m_pods, m_isFirstTurn);
+	array<PodOutput, POD_CONTROLLABLE_NB> fallbackOutputs = HeuristicPolicy::ComputeOutputs(m_simulation);
+	if (isDeterministic) _watchdog = nullptr; // The fallback depends on the clock, the budgeted moves must not
+	if (_watchdog != nullptr) _watchdog->Arm(m_isFirstTurn ? FIRST_TURN_WATCHDOG_DEADLINE : WATCHDOG_DEADLINE, fallbackOutputs);
+	if (m_isFirstTurn) MapAnalysis::Analyze(&m_simulation, &m_scheduler.GetRacer());
+	bool isPonderKept = m_ponderer.Stop(&m_scheduler.GetRacer(), m_simulation);
+
+	// Never play a plan worse than the heuristic one, nor answer after the watchdog
+	array<PodOutput, POD_CONTROLLABLE_NB> outputs = m_scheduler.Solve(m_parameters.m_timeAllocatedPerTurn, isPonderKept, fallbackOutputs);
+	m_hasWatchdogAnswered = _watchdog != nullptr && false == _watchdog->Claim();
+	if (m_hasWatchdogAnswered) outputs = fallbackOutputs;
+	m_simulation.ApplyOutputs(outputs);
+
+	// Effective rate of the search, the number to compare the same budgeted run across machines and versions
+	m_nbSimulatedTurn += m_simulation.GetSimulatedTurnCount() - firstSimulatedTurnCount;
+	m_searchMicroseconds += duration_cast<microseconds>(high_resolution_clock::now() - startTime).count();
+	DEBUG_LOG << m_nbSimulatedTurn << " simulated turns at " << GetSimulatedTurnsPerMillisecond() << " per ms since the first turn" << endl;
+
+	m_nbTurn++;
+	if (_watchdog != nullptr)
+	{
+		DEBUG_LOG << "Fallback used by the watchdog " << _watchdog->GetFallbackSentCount() << " and below the heuristic " << m_scheduler.GetBelowHeuristicCount() << " times in " << m_nbTurn << " turns" << endl;
+	}
+
+	m_isFirstTurn = false;
+	return outputs;
+}
+
+void GoldBot::Ponder()
+{
+	// The work done between turns depends on when the next input comes
+	if (m_parameters.m_simulationBudget > 0) return;
+	m_ponderer.Start(m_simulation, m_scheduler.GetRacer());
+}
+
+#pragma endregion
+
+#ifndef GOLD_NO_MAIN // Tools embed this file and drive GoldBot themselves
+
+// Without arguments the bot searches on the clock, like in the arena.
+// Usage : gold [--simulations budget] [--seed seed] for the deterministic search of the benchmarks
+int main(int _argc, char** _argv)
+{
+	SearchParameters parameters;
+	for (int iArgument = 1; iArgument + 1 < _argc; iArgument += 2)
+	{
+		const string argument = _argv[iArgument];
+		if (argument == "--simulations") parameters.m_simulationBudget = max(atoi(_argv[iArgument + 1]), 0);
+		else if (argument == "--seed") parameters.m_seed = (unsigned int)atoi(_argv[iArgument + 1]);
+	}
+
+	GoldBot bot(parameters);
+	Watchdog watchdog(cout);
+	Watchdog* turnWatchdog = parameters.m_simulationBudget > 0 ? nullptr : &watchdog; // A budgeted search always plays its own moves
+
+	bot.Init(ReadMapInput(cin));
+
+	long long timeUsed = 0;
+
+	while (1)
+	{
+		DEBUG_LOG << "Time used for last frame = " << timeUsed << endl;
+		auto startTime = high_resolution_clock::now();
+
+		array<PodOutput, POD_CONTROLLABLE_NB> outputs = bot.Step(ReadTurnInput(cin), turnWatchdog);
+		if (false == bot.HasWatchdogAnswered()) WriteOutputs(cout, outputs);
+		bot.Ponder();
+
+		timeUsed = duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count();
+	}
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+// Generated by Tools/RacingLineOptimizer.cpp with 300ms per turn, 4 restarts per map and 20000 simulations per turn of the boost races
+
+#define KNOWN_MAP_COUNT 13
+
+constexpr KnownMap KNOWN_MAPS[KNOWN_MAP_COUNT > 0 ? KNOWN_MAP_COUNT : 1] =
+{
+	{ 4, { { 12460, 1350 }, { 10540, 5980 }, { 3580, 5180 }, { 13580, 7600 } }, { { 393, 85 }, { -487, -115 }, { 482, -134 }, { 134, -482 } }, { -1, 0, -1, -1 } },
+	{ 5, { { 3600, 5280 }, { 13840, 5080 }, { 10680, 2280 }, { 8700, 7460 }, { 7200, 2160 } }, { { -375, -331 }, { -376, -329 }, { 483, 50 }, { -184, -465 }, { -90, 492 } }, { 4, 1, -1, -1, -1 } },
+	{ 6, { { 4560, 2180 }, { 7350, 4940 }, { 3320, 7230 }, { 14580, 7700 }, { 10560, 5060 }, { 13100, 2320 } }, { { 467, 179 }, { -376, 330 }, { 430, -234 }, { -374, -297 }, { 321, -383 }, { -454, -121 } }, { 4, -1, 4, 2, -1, -1 } },
+	{ 3, { { 5010, 5260 }, { 11480, 6080 }, { 9100, 1840 } }, { { -14, -293 }, { -420, -272 }, { 360, 347 } }, { -1, -1, -1 } },
+	{ 4, { { 14660, 1410 }, { 3450, 7220 }, { 9420, 7240 }, { 5970, 4240 } }, { { -407, 290 }, { 500, -2 }, { -385, -319 }, { 411, -285 } }, { 0, -1, 2, -1 } },
+	{ 4, { { 3640, 4420 }, { 8000, 7900 }, { 13300, 5540 }, { 9560, 1400 } }, { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }, { -1, -1, -1, -1 } },
+	{ 4, { { 4100, 7420 }, { 13500, 2340 }, { 12940, 7220 }, { 5640, 2580 } }, { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }, { 0, 0, 2, 2 } },
+	{ 6, { { 14520, 7780 }, { 6320, 4290 }, { 7800, 860 }, { 7660, 5970 }, { 3140, 7540 }, { 9520, 4380 } }, { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }, { 4, -1, -1, -1, -1, 4 } },
+	{ 4, { { 10040, 5970 }, { 13920, 1940 }, { 8020, 3260 }, { 2670, 7020 } }, { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }, { -1, 3, -1, -1 } },
+	{ 3, { { 7500, 6940 }, { 6000, 5360 }, { 11300, 2820 } }, { { 0, 0 }, { 0, 0 }, { 0, 0 } }, { -1, -1, -1 } },
+	{ 5, { { 4060, 4660 }, { 13040, 1900 }, { 6560, 7840 }, { 7480, 1360 }, { 12700, 7100 } }, { { 297, 402 }, { -376, 329 }, { 117, -486 }, { 219, 450 }, { -500, 3 } }, { -1, -1, -1, -1, -1 } },
+	{ 6, { { 3020, 5190 }, { 6280, 7760 }, { 14100, 7760 }, { 13880, 1220 }, { 10240, 4920 }, { 6100, 2200 } }, { { -417, -68 }, { 41, 498 }, { -215, -451 }, { -212, 453 }, { -401, -299 }, { -443, 231 } }, { 3, -1, -1, 1, -1, 4 } },
+	{ 4, { { 10323, 3366 }, { 11203, 5425 }, { 7259, 6656 }, { 5425, 2838 } }, { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }, { 3, -1, -1, 1 } },
+};
@@ -0,0 +1,239 @@
+// Decision quality of the Gold.cpp solver as a function of its time budget, on a fixed corpus of positions.
+// Build : g++ -std=c++17 -O2 -pthread Tools/AnytimeBenchmark.cpp Tools/Referee.cpp -o AnytimeBenchmark
+// Usage : AnytimeBenchmark [positions] [maximumMilliseconds] [referenceMilliseconds]
+// Prints one curve per configuration : score gap and agreement with the move found by a long reference search.
+// The searches are timed, run it alone on the machine.
+
+#define GOLD_NO_MAIN
+#define GOLD_SILENT
+#include "../Gold.cpp"
+
+#include "Referee.h"
+
+#include <iomanip>
+
+#define BENCHMARK_DEFAULT_POSITIONS 8
+#define BENCHMARK_DEFAULT_MAXIMUM_MILLISECONDS 1000
+#define BENCHMARK_DEFAULT_REFERENCE_MILLISECONDS 2000
+#define BENCHMARK_SAMPLE_FREQUENCY 23 // Turns between two positions of the same game, prime so the phases of the race vary
+#define BENCHMARK_FIRST_SAMPLE_TURN 5
+#define BENCHMARK_SEED 4242u
+
+// A first move agrees with the reference when it is this close
+#define BENCHMARK_ROTATION_TOLERANCE 3
+#define BENCHMARK_THRUST_TOLERANCE 15
+
+const int BENCHMARK_BUDGETS[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+
+#pragma region Position Corpus
+
+struct BenchmarkPosition
+{
+	vector<RefereePoint> m_checkpoints;
+	int m_numberOfLaps = 0;
+	int m_turn = 0;
+	array<RefereePodInput, REFEREE_POD_TOTAL_NB> m_inputs; // Point of view of player 0
+	array<RefereePod, REFEREE_POD_TOTAL_NB> m_pods; // Hidden state of the referee, like the boost already used
+};
+
+Simulation CreateSimulation(const vector<RefereePoint>& _checkpoints, int _numberOfLaps)
+{
+	vector<Vector2> checkpointPositions;
+	for (const RefereePoint& checkpoint : _checkpoints) checkpointPositions.push_back(Vector2((float)checkpoint.m_x, (float)checkpoint.m_y));
+	Simulation simulation;
+	simulation.InitializeCheckpoints(_numberOfLaps, checkpointPositions);
+	return simulation;
+}
+
+array<PodInput, POD_TOTAL_NB> CreatePodsInputs(const array<RefereePodInput, REFEREE_POD_TOTAL_NB>& _inputs)
+{
+	array<PodInput, POD_TOTAL_NB> inputs;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		inputs[iPod].m_x = _inputs[iPod].m_x;
+		inputs[iPod].m_y = _inputs[iPod].m_y;
+		inputs[iPod].m_speedX = _inputs[iPod].m_speedX;
+		inputs[iPod].m_speedY = _inputs[iPod].m_speedY;
+		inputs[iPod].m_angle = _inputs[iPod].m_angle;
+		inputs[iPod].m_nextCheckpointIndex = _inputs[iPod].m_nextCheckpointIndex;
+	}
+	return inputs;
+}
+
+// Both players follow the heuristic policy, which uses no clock, so the corpus is the same on every run
+vector<BenchmarkPosition> CreateCorpus(int _positionCount)
+{
+	vector<BenchmarkPosition> corpus;
+	for (int iGame = 0; (int)corpus.size() < _positionCount; iGame++)
+	{
+		Referee referee;
+		referee.Initialize(iGame % Referee::GetMapCount(), BENCHMARK_SEED + (unsigned int)iGame * 7919u);
+
+		array<Simulation, REFEREE_PLAYER_NB> simulations;
+		for (Simulation& simulation : simulations) simulation = CreateSimulation(referee.GetCheckpoints(), referee.GetNumberOfLaps());
+
+		while (false == referee.IsOver() && (int)corpus.size() < _positionCount)
+		{
+			const int turn = referee.GetTurn();
+			if (turn >= BENCHMARK_FIRST_SAMPLE_TURN && (turn - BENCHMARK_FIRST_SAMPLE_TURN) % BENCHMARK_SAMPLE_FREQUENCY == 0)
+			{
+				BenchmarkPosition position;
+				position.m_checkpoints = referee.GetCheckpoints();
+				position.m_numberOfLaps = referee.GetNumberOfLaps();
+				position.m_turn = turn;
+				position.m_inputs = referee.GetPodsInputs(0);
+				position.m_pods = referee.GetPods();
+				corpus.push_back(position);
+			}
+
+			array<array<RefereeCommand, REFEREE_POD_PER_PLAYER>, REFEREE_PLAYER_NB> commands;
+			for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+			{
+				Simulation& simulation = simulations[iPlayer];
+				simulation.ApplyPodsInputs(CreatePodsInputs(referee.GetPodsInputs(iPlayer)), turn == 0);
+				array<PodOutput, POD_CONTROLLABLE_NB> outputs = HeuristicPolicy::ComputeOutputs(simulation);
+				simulation.ApplyOutputs(outputs);
+				for (int iPod = 0; iPod < REFEREE_POD_PER_PLAYER; iPod++)
+				{
+					RefereeCommand& command = commands[iPlayer][iPod];
+					command.m_targetX = (int)outputs[iPod].m_target.m_x;
+					command.m_targetY = (int)outputs[iPod].m_target.m_y;
+					command.m_thrust = outputs[iPod].m_thrust;
+					command.m_useBoost = outputs[iPod].m_useBoost;
+					command.m_useShield = outputs[iPod].m_useShield;
+				}
+			}
+			referee.PlayTurn(commands[0], commands[1]);
+		}
+	}
+	return corpus;
+}
+
+// The simulation of player 0 as the bot would hold it on that turn
+void LoadPosition(const BenchmarkPosition& _position, Simulation* _simulation)
+{
+	*_simulation = CreateSimulation(_position.m_checkpoints, _position.m_numberOfLaps);
+	_simulation->ApplyPodsInputs(CreatePodsInputs(_position.m_inputs), _position.m_turn == 0);
+	_simulation->m_turn = _position.m_turn;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		Pod& pod = _simulation->m_pods[iPod];
+		const RefereePod& refereePod = _position.m_pods[iPod];
+		pod.m_currentCheckpointIndex = refereePod.m_nextCheckpointIndex;
+		pod.m_checkpointPassedCount = refereePod.m_checkpointPassedCount;
+		pod.m_usedBoost = refereePod.m_usedBoost;
+		pod.m_shieldCooldown = refereePod.m_shieldCooldown;
+	}
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+struct EngineConfiguration
+{
+	string m_name;
+	SearchParameters m_parameters;
+};
+
+// Parameter sets compared on the same corpus, a faster engine is compared by building this tool on both versions
+vector<EngineConfiguration> CreateConfigurations()
+{
+	vector<EngineConfiguration> configurations;
+	configurations.push_back({ "default", SearchParameters() });
+
+	EngineConfiguration largePopulation = { "population x4", SearchParameters() };
+	largePopulation.m_parameters.m_solutionsCount *= 4;
+	configurations.push_back(largePopulation);
+
+	EngineConfiguration noHeuristicSeed = { "no heuristic seed", SearchParameters() };
+	noHeuristicSeed.m_parameters.m_heuristicSeedsCount = 0;
+	configurations.push_back(noHeuristicSeed);
+
+	return configurations;
+}
+
+struct SearchResult
+{
+	int m_score = 0;
+	Move m_firstMove;
+	long long m_simulatedTurns = 0;
+};
+
+// Fresh solver on every search, like the first turn of a game : nothing is learned from the previous budget
+SearchResult RunSearch(const BenchmarkPosition& _position, const SearchParameters& _parameters, int _milliseconds, unsigned int _seed)
+{
+	Random::SetSeed(_seed);
+
+	Simulation simulation;
+	LoadPosition(_position, &simulation);
+	SearchParameters parameters = _parameters;
+	parameters.m_timeAllocatedPerTurn = _milliseconds;
+
+	Solver solver(&simulation, parameters);
+	const Solution& solution = solver.Solve();
+
+	SearchResult result;
+	result.m_score = solution.m_score;
+	result.m_firstMove = solution.m_turns[0].m_moves[RACER_POD_INDEX];
+	result.m_simulatedTurns = simulation.GetSimulatedTurnCount();
+	return result;
+}
+
+bool AreMovesAgreeing(const Move& _move, const Move& _reference)
+{
+	return abs(_move.m_rotation - _reference.m_rotation) <= BENCHMARK_ROTATION_TOLERANCE
+		&& abs(_move.m_thrust - _reference.m_thrust) <= BENCHMARK_THRUST_TOLERANCE
+		&& _move.m_useBoost == _reference.m_useBoost
+		&& _move.m_useShield == _reference.m_useShield;
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	const int positionCount = max(_argc > 1 ? atoi(_argv[1]) : BENCHMARK_DEFAULT_POSITIONS, 1);
+	const int maximumMilliseconds = _argc > 2 ? atoi(_argv[2]) : BENCHMARK_DEFAULT_MAXIMUM_MILLISECONDS;
+	const int referenceMilliseconds = _argc > 3 ? atoi(_argv[3]) : BENCHMARK_DEFAULT_REFERENCE_MILLISECONDS;
+
+	vector<int> budgets;
+	for (int budget : BENCHMARK_BUDGETS)
+	{
+		if (budget <= maximumMilliseconds) budgets.push_back(budget);
+	}
+
+	const vector<BenchmarkPosition> corpus = CreateCorpus(positionCount);
+	const vector<EngineConfiguration> configurations = CreateConfigurations();
+	cout << corpus.size() << " positions, " << configurations.size() << " configurations, reference search of " << referenceMilliseconds << "ms" << endl;
+	cout << "configuration,milliseconds,meanScore,meanScoreGap,agreement,simulatedTurnsPerMillisecond" << endl;
+
+	for (const EngineConfiguration& configuration : configurations)
+	{
+		vector<SearchResult> references;
+		for (size_t iPosition = 0; iPosition < corpus.size(); iPosition++)
+		{
+			references.push_back(RunSearch(corpus[iPosition], configuration.m_parameters, referenceMilliseconds, BENCHMARK_SEED + (unsigned int)iPosition));
+		}
+
+		for (int budget : budgets)
+		{
+			double scoreSum = 0.0;
+			double scoreGapSum = 0.0;
+			int agreementCount = 0;
+			long long simulatedTurns = 0;
+			for (size_t iPosition = 0; iPosition < corpus.size(); iPosition++)
+			{
+				// Another seed than the reference, so that agreeing means converging and not replaying the same search
+				SearchResult result = RunSearch(corpus[iPosition], configuration.m_parameters, budget, BENCHMARK_SEED * 2u + (unsigned int)iPosition);
+				scoreSum += result.m_score;
+				scoreGapSum += references[iPosition].m_score - result.m_score;
+				if (AreMovesAgreeing(result.m_firstMove, references[iPosition].m_firstMove)) agreementCount++;
+				simulatedTurns += result.m_simulatedTurns;
+			}
+
+			const double positions = (double)corpus.size();
+			cout << configuration.m_name << "," << budget << "," << fixed << setprecision(1) << scoreSum / positions << "," << scoreGapSum / positions
+				<< "," << setprecision(3) << agreementCount / positions << "," << setprecision(1) << simulatedTurns / (positions * budget) << endl;
+		}
+	}
+}
@@ -0,0 +1,118 @@
+// Plays many Gold.cpp games in one process through the GoldBot interface, without pipes nor spawned processes.
+// Build : g++ -std=c++17 -O2 -pthread Tools/BatchRunner.cpp Tools/Referee.cpp -o BatchRunner
+// Usage : BatchRunner [games] [millisecondsPerTurn] [gamesPerThread]
+
+#define GOLD_NO_MAIN
+#define GOLD_SILENT
+#include "../Gold.cpp"
+
+#include "Referee.h"
+#include "GoldPlayer.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#define RUNNER_DEFAULT_GAMES 64
+#define RUNNER_DEFAULT_MILLISECONDS_PER_TURN 2
+#define RUNNER_DEFAULT_GAMES_PER_THREAD 16
+
+#pragma region Batch
+
+struct Match
+{
+	Referee m_referee;
+	array<unique_ptr<GoldPlayer>, REFEREE_PLAYER_NB> m_players;
+};
+
+struct BatchResult
+{
+	array<int, REFEREE_PLAYER_NB> m_wins = {};
+	int m_draws = 0;
+	long long m_turns = 0;
+};
+
+// Every thread advances all of its matches one turn at a time, so the bots of many games live in the process at once
+void PlayMatches(int _firstGame, int _gameCount, const SearchParameters& _parameters, BatchResult* _result)
+{
+	vector<Match> matches(_gameCount);
+	for (int iMatch = 0; iMatch < _gameCount; iMatch++)
+	{
+		Match& match = matches[iMatch];
+		const unsigned int seed = 1000u + (unsigned int)(_firstGame + iMatch) * 7919u;
+		match.m_referee.Initialize((_firstGame + iMatch) % Referee::GetMapCount(), seed);
+		for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+		{
+			match.m_players[iPlayer] = make_unique<GoldPlayer>(_parameters);
+			match.m_players[iPlayer]->Initialize(match.m_referee);
+		}
+	}
+
+	bool isRunning = true;
+	while (isRunning)
+	{
+		isRunning = false;
+		for (Match& match : matches)
+		{
+			if (match.m_referee.IsOver()) continue;
+			isRunning = true;
+
+			array<RefereeCommand, REFEREE_POD_PER_PLAYER> commandsPlayer0 = match.m_players[0]->PlayTurn(match.m_referee.GetPodsInputs(0));
+			array<RefereeCommand, REFEREE_POD_PER_PLAYER> commandsPlayer1 = match.m_players[1]->PlayTurn(match.m_referee.GetPodsInputs(1));
+			match.m_referee.PlayTurn(commandsPlayer0, commandsPlayer1);
+		}
+	}
+
+	for (Match& match : matches)
+	{
+		const int winner = match.m_referee.GetWinner();
+		if (winner < 0) _result->m_draws++;
+		else _result->m_wins[winner]++;
+		_result->m_turns += match.m_referee.GetTurn();
+	}
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	const unsigned int threadCount = max(1u, thread::hardware_concurrency());
+	const int games = max(_argc > 1 ? atoi(_argv[1]) : RUNNER_DEFAULT_GAMES, 1);
+	const int millisecondsPerTurn = _argc > 2 ? atoi(_argv[2]) : RUNNER_DEFAULT_MILLISECONDS_PER_TURN;
+	const int gamesPerThread = max(_argc > 3 ? atoi(_argv[3]) : RUNNER_DEFAULT_GAMES_PER_THREAD, 1);
+
+	SearchParameters parameters;
+	parameters.m_timeAllocatedPerTurn = millisecondsPerTurn;
+	parameters.m_mapAnalysisTime = MAP_ANALYSIS_TIME * millisecondsPerTurn / TIME_ALLOCATED_PER_TURN;
+
+	cout << "Playing " << games << " games at " << millisecondsPerTurn << "ms per turn, " << gamesPerThread << " at once on each of " << threadCount << " threads" << endl;
+	auto startTime = high_resolution_clock::now();
+
+	// Games are handed out by groups, each group is played in lock step by one thread
+	const int groupCount = (games + gamesPerThread - 1) / gamesPerThread;
+	vector<BatchResult> results(groupCount);
+	atomic<int> nextGroup(0);
+	auto worker = [&]()
+	{
+		for (int iGroup = nextGroup++; iGroup < groupCount; iGroup = nextGroup++)
+		{
+			const int firstGame = iGroup * gamesPerThread;
+			PlayMatches(firstGame, min(gamesPerThread, games - firstGame), parameters, &results[iGroup]);
+		}
+	};
+	vector<thread> threads;
+	for (unsigned int iThread = 0; iThread < threadCount; iThread++) threads.emplace_back(worker);
+	for (thread& workerThread : threads) workerThread.join();
+
+	BatchResult total;
+	for (const BatchResult& result : results)
+	{
+		for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++) total.m_wins[iPlayer] += result.m_wins[iPlayer];
+		total.m_draws += result.m_draws;
+		total.m_turns += result.m_turns;
+	}
+
+	double seconds = duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count() / 1000.0;
+	cout << "Player 0 won " << total.m_wins[0] << ", player 1 won " << total.m_wins[1] << ", " << total.m_draws << " draws" << endl;
+	cout << total.m_turns / games << " turns per game, " << games / max(seconds, 0.001) << " games per second" << endl;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Adapter from the referee structures to GoldBot, shared by the tools.
+// Include it after Gold.cpp and Referee.h.
+
+#pragma region Gold Player
+
+// Drives one Gold.cpp bot from the referee structures, without going through cin/cout
+class GoldPlayer
+{
+public:
+
+	GoldPlayer(const SearchParameters& _parameters) : m_bot(_parameters) {}
+
+	void Initialize(const Referee& _referee);
+	array<RefereeCommand, REFEREE_POD_PER_PLAYER> PlayTurn(const array<RefereePodInput, REFEREE_POD_TOTAL_NB>& _inputs);
+
+private:
+
+	GoldBot m_bot;
+};
+
+inline void GoldPlayer::Initialize(const Referee& _referee)
+{
+	MapInput mapInput;
+	mapInput.m_numberOfLaps = _referee.GetNumberOfLaps();
+	for (const RefereePoint& checkpoint : _referee.GetCheckpoints())
+	{
+		mapInput.m_checkpoints.push_back(Vector2((float)checkpoint.m_x, (float)checkpoint.m_y));
+	}
+	m_bot.Init(mapInput);
+}
+
+inline array<RefereeCommand, REFEREE_POD_PER_PLAYER> GoldPlayer::PlayTurn(const array<RefereePodInput, REFEREE_POD_TOTAL_NB>& _inputs)
+{
+	TurnInput turnInput;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		PodInput& input = turnInput.m_pods[iPod];
+		input.m_x = _inputs[iPod].m_x;
+		input.m_y = _inputs[iPod].m_y;
+		input.m_speedX = _inputs[iPod].m_speedX;
+		input.m_speedY = _inputs[iPod].m_speedY;
+		input.m_angle = _inputs[iPod].m_angle;
+		input.m_nextCheckpointIndex = _inputs[iPod].m_nextCheckpointIndex;
+	}
+	array<PodOutput, POD_CONTROLLABLE_NB> outputs = m_bot.Step(turnInput);
+
+	array<RefereeCommand, REFEREE_POD_PER_PLAYER> commands;
+	for (int iPod = 0; iPod < REFEREE_POD_PER_PLAYER; iPod++)
+	{
+		commands[iPod].m_targetX = (int)outputs[iPod].m_target.m_x;
+		commands[iPod].m_targetY = (int)outputs[iPod].m_target.m_y;
+		commands[iPod].m_thrust = outputs[iPod].m_thrust;
+		commands[iPod].m_useBoost = outputs[iPod].m_useBoost;
+		commands[iPod].m_useShield = outputs[iPod].m_useShield;
+	}
+	return commands;
+}
+
+#pragma endregion
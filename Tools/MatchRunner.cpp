@@ -0,0 +1,916 @@
+// Plays bot executables against each other through pipes, like the arena, optionally on a loaded machine.
+// Build : g++ -std=c++17 -O2 -pthread Tools/MatchRunner.cpp Tools/Referee.cpp -o MatchRunner
+// Usage : MatchRunner [--games n] [--threads n] [--busy threads] [--quota percent] [--period ms] [--jitter ms] [--cpu index] [--seed s]
+//                     [--results file] [--sprt elo0 elo1] [--alpha a] [--beta b] [bot...]
+//   bot       a command line, e.g. "./gold --simulations 5000" for a fast and reproducible verdict
+//   --games   largest number of games of the session, played in pairs with the sides swapped on the same map
+//   --threads games played at the same time, half the processors by default
+//   --busy    threads spinning in the runner for the whole session
+//   --quota   share of every period the bots may run, the rest of it they are stopped like a throttled cgroup
+//   --jitter  largest delay between the start of the turn clock and the delivery of the input on stdin
+//   --cpu     pins the bots and the busy threads on this processor
+//   --results every game is appended to this file, the stored games of every build are part of the ratings
+//   --sprt    stops a match between two builds once the Elo difference is known to be below elo0 or above elo1,
+//             with the error rates alpha and beta, 0.05 by default
+// With more than two builds, each match goes to the pair with the most uncertain result. The ratings are Bradley-Terry Elo.
+// The response time of every turn is measured from the start of the turn clock to the last output line, per bot build.
+// Linux only, the bots are built separately, e.g. g++ -std=c++17 -O2 -pthread Gold.cpp -o gold
+
+#include "Referee.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+#define RUNNER_DEFAULT_GAMES 10
+#define RUNNER_DEFAULT_QUOTA_PERIOD 100 // Milliseconds, the default period of the Linux CFS bandwidth control
+#define RUNNER_TURN_LIMIT 75 // Milliseconds given by the arena
+#define RUNNER_FIRST_TURN_LIMIT 1000
+#define RUNNER_KILL_DELAY 1000 // A late answer is still used to keep the game going, a missing one loses the game
+#define RUNNER_GAME_NOT_PLAYED -2 // A bot could not be started, the machine is to blame and not the builds
+#define RUNNER_DEFAULT_SPRT_ELO 10.0
+#define RUNNER_DEFAULT_SPRT_ERROR 0.05
+#define RATINGS_ELO_SCALE 400.0 // Elo points between two builds when one is 10 times stronger
+#define RATINGS_CONFIDENCE 1.96 // Standard deviations in the 95% confidence interval
+#define RATINGS_UNKNOWN_ERROR 1000.0 // Elo error of a build without games
+#define RATINGS_ITERATION_NB 200
+
+#pragma region Bot Process
+
+class BotProcess
+{
+public:
+
+	bool Start(const string& _command, int _cpu);
+	void Stop();
+	bool Write(const string& _text);
+	bool ReadLine(string* _line, high_resolution_clock::time_point _deadline);
+	pid_t GetPid() const { return m_pid; }
+
+private:
+
+	pid_t m_pid = -1;
+	int m_input = -1; // Standard input of the bot
+	int m_output = -1; // Standard output of the bot
+	string m_buffer;
+};
+
+// The command is split on spaces, so a build can be given its arguments
+bool BotProcess::Start(const string& _command, int _cpu)
+{
+	// Nothing is allocated after the fork, other games may be holding locks in their threads
+	vector<string> arguments;
+	istringstream stream(_command);
+	for (string argument; stream >> argument;) arguments.push_back(argument);
+	if (arguments.empty()) return false;
+	vector<char*> argumentPointers;
+	for (string& argument : arguments) argumentPointers.push_back(&argument[0]);
+	argumentPointers.push_back(nullptr);
+
+	// Close on exec, so the bots of the games played in parallel do not hold the pipes of each other
+	int inputPipe[2];
+	int outputPipe[2];
+	if (pipe2(inputPipe, O_CLOEXEC) != 0) return false;
+	if (pipe2(outputPipe, O_CLOEXEC) != 0)
+	{
+		close(inputPipe[0]);
+		close(inputPipe[1]);
+		return false;
+	}
+
+	m_pid = fork();
+	if (m_pid < 0)
+	{
+		for (int file : { inputPipe[0], inputPipe[1], outputPipe[0], outputPipe[1] }) close(file);
+		m_pid = -1;
+		return false;
+	}
+	if (m_pid == 0)
+	{
+		dup2(inputPipe[0], STDIN_FILENO);
+		dup2(outputPipe[1], STDOUT_FILENO);
+		int nullFile = open("/dev/null", O_WRONLY);
+		dup2(nullFile, STDERR_FILENO); // The debug log would fill the pipe
+		if (_cpu >= 0)
+		{
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			CPU_SET(_cpu, &cpuSet);
+			sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+		}
+		execv(argumentPointers[0], argumentPointers.data());
+		_exit(127);
+	}
+
+	close(inputPipe[0]);
+	close(outputPipe[1]);
+	m_input = inputPipe[1];
+	m_output = outputPipe[0];
+	m_buffer.clear();
+	return true;
+}
+
+void BotProcess::Stop()
+{
+	if (m_pid <= 0) return;
+	kill(m_pid, SIGCONT);
+	kill(m_pid, SIGKILL);
+	waitpid(m_pid, nullptr, 0);
+	close(m_input);
+	close(m_output);
+	m_pid = -1;
+}
+
+bool BotProcess::Write(const string& _text)
+{
+	size_t written = 0;
+	while (written < _text.size())
+	{
+		ssize_t result = write(m_input, _text.data() + written, _text.size() - written);
+		if (result <= 0) return false;
+		written += (size_t)result;
+	}
+	return true;
+}
+
+bool BotProcess::ReadLine(string* _line, high_resolution_clock::time_point _deadline)
+{
+	while (true)
+	{
+		size_t lineEnd = m_buffer.find('\n');
+		if (lineEnd != string::npos)
+		{
+			*_line = m_buffer.substr(0, lineEnd);
+			m_buffer.erase(0, lineEnd + 1);
+			return true;
+		}
+
+		int timeLeft = (int)duration_cast<milliseconds>(_deadline - high_resolution_clock::now()).count();
+		if (timeLeft <= 0) return false;
+		pollfd pollFile = { m_output, POLLIN, 0 };
+		if (poll(&pollFile, 1, timeLeft) <= 0) continue;
+
+		char data[4096];
+		ssize_t result = read(m_output, data, sizeof(data));
+		if (result <= 0) return false;
+		m_buffer.append(data, (size_t)result);
+	}
+}
+
+#pragma endregion
+
+#pragma region Machine Load
+
+// Threads burning the processor for the whole session
+class BusyThreads
+{
+public:
+
+	void Start(int _count, int _cpu);
+	void Stop();
+
+private:
+
+	vector<thread> m_threads;
+	atomic<bool> m_isRunning = false;
+};
+
+void BusyThreads::Start(int _count, int _cpu)
+{
+	m_isRunning = true;
+	for (int iThread = 0; iThread < _count; iThread++)
+	{
+		m_threads.emplace_back([this, _cpu]()
+		{
+			if (_cpu >= 0)
+			{
+				cpu_set_t cpuSet;
+				CPU_ZERO(&cpuSet);
+				CPU_SET(_cpu, &cpuSet);
+				sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+			}
+			volatile unsigned long long counter = 0;
+			while (m_isRunning.load(memory_order_relaxed)) counter = counter + 1;
+		});
+	}
+}
+
+void BusyThreads::Stop()
+{
+	m_isRunning = false;
+	for (thread& busyThread : m_threads) busyThread.join();
+	m_threads.clear();
+}
+
+// Stops the bots for the end of every period, like a cgroup that used its quota
+class QuotaThrottler
+{
+public:
+
+	void Start(int _quota, int _period);
+	void Stop();
+	void AddBots(const vector<pid_t>& _pids);
+	void RemoveBots(const vector<pid_t>& _pids);
+
+private:
+
+	void Signal(int _signal);
+
+	thread m_thread;
+	mutex m_mutex;
+	vector<pid_t> m_pids;
+	atomic<bool> m_isRunning = false;
+};
+
+void QuotaThrottler::Start(int _quota, int _period)
+{
+	if (_quota >= 100) return;
+	m_isRunning = true;
+	m_thread = thread([this, _quota, _period]()
+	{
+		const microseconds runTime(_period * 1000 * _quota / 100);
+		const microseconds stopTime(_period * 1000 - runTime.count());
+		while (m_isRunning)
+		{
+			Signal(SIGCONT);
+			this_thread::sleep_for(runTime);
+			Signal(SIGSTOP);
+			this_thread::sleep_for(stopTime);
+		}
+		Signal(SIGCONT);
+	});
+}
+
+void QuotaThrottler::Stop()
+{
+	if (false == m_isRunning) return;
+	m_isRunning = false;
+	m_thread.join();
+}
+
+void QuotaThrottler::AddBots(const vector<pid_t>& _pids)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for (pid_t pid : _pids)
+	{
+		if (pid > 0) m_pids.push_back(pid); // A kill of pid -1 would reach every process of the user
+	}
+}
+
+void QuotaThrottler::RemoveBots(const vector<pid_t>& _pids)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for (pid_t pid : _pids)
+	{
+		if (pid <= 0) continue;
+		kill(pid, SIGCONT);
+		m_pids.erase(remove(m_pids.begin(), m_pids.end(), pid), m_pids.end());
+	}
+}
+
+void QuotaThrottler::Signal(int _signal)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for (pid_t pid : m_pids)
+	{
+		if (pid > 0) kill(pid, _signal);
+	}
+}
+
+#pragma endregion
+
+#pragma region Latency Report
+
+struct BuildStatistics
+{
+	vector<double> m_latencies; // Milliseconds, every turn but the first one
+	vector<double> m_firstTurnLatencies;
+	int m_timeouts = 0;
+	int m_firstTurnTimeouts = 0;
+	int m_missingAnswers = 0;
+
+	void Merge(const BuildStatistics& _other);
+};
+
+void BuildStatistics::Merge(const BuildStatistics& _other)
+{
+	m_latencies.insert(m_latencies.end(), _other.m_latencies.begin(), _other.m_latencies.end());
+	m_firstTurnLatencies.insert(m_firstTurnLatencies.end(), _other.m_firstTurnLatencies.begin(), _other.m_firstTurnLatencies.end());
+	m_timeouts += _other.m_timeouts;
+	m_firstTurnTimeouts += _other.m_firstTurnTimeouts;
+	m_missingAnswers += _other.m_missingAnswers;
+}
+
+double Percentile(vector<double> _values, double _ratio)
+{
+	if (_values.empty()) return 0.0;
+	sort(_values.begin(), _values.end());
+	return _values[min(_values.size() - 1, (size_t)(_ratio * _values.size()))];
+}
+
+void PrintStatistics(const string& _build, const BuildStatistics& _statistics)
+{
+	cout << _build << endl;
+	cout << fixed << setprecision(2) << "  turn latency ms  p50 " << Percentile(_statistics.m_latencies, 0.5)
+		<< "  p99 " << Percentile(_statistics.m_latencies, 0.99) << "  p999 " << Percentile(_statistics.m_latencies, 0.999)
+		<< "  max " << Percentile(_statistics.m_latencies, 1.0) << "  over " << _statistics.m_latencies.size() << " turns" << endl;
+	cout << "  first turn ms    p50 " << Percentile(_statistics.m_firstTurnLatencies, 0.5) << "  max " << Percentile(_statistics.m_firstTurnLatencies, 1.0) << endl;
+	cout << "  timeouts " << _statistics.m_timeouts << " (over " << RUNNER_TURN_LIMIT << "ms), first turn " << _statistics.m_firstTurnTimeouts
+		<< " (over " << RUNNER_FIRST_TURN_LIMIT << "ms), missing answers " << _statistics.m_missingAnswers << endl;
+}
+
+#pragma endregion
+
+#pragma region Match
+
+struct RunnerOptions
+{
+	int m_games = RUNNER_DEFAULT_GAMES;
+	int m_threads = 1;
+	int m_busyThreads = 0;
+	int m_quota = 100;
+	int m_quotaPeriod = RUNNER_DEFAULT_QUOTA_PERIOD;
+	int m_jitter = 0;
+	int m_cpu = -1;
+	unsigned int m_seed = 1000u;
+	bool m_isSprt = false;
+	double m_elo0 = 0.0;
+	double m_elo1 = RUNNER_DEFAULT_SPRT_ELO;
+	double m_alpha = RUNNER_DEFAULT_SPRT_ERROR;
+	double m_beta = RUNNER_DEFAULT_SPRT_ERROR;
+	string m_resultsPath;
+};
+
+string FormatMapInput(const Referee& _referee)
+{
+	ostringstream stream;
+	stream << _referee.GetNumberOfLaps() << "\n" << _referee.GetCheckpoints().size() << "\n";
+	for (const RefereePoint& checkpoint : _referee.GetCheckpoints()) stream << checkpoint.m_x << " " << checkpoint.m_y << "\n";
+	return stream.str();
+}
+
+string FormatTurnInput(const array<RefereePodInput, REFEREE_POD_TOTAL_NB>& _inputs)
+{
+	ostringstream stream;
+	for (const RefereePodInput& input : _inputs)
+	{
+		stream << input.m_x << " " << input.m_y << " " << input.m_speedX << " " << input.m_speedY << " " << input.m_angle << " " << input.m_nextCheckpointIndex << "\n";
+	}
+	return stream.str();
+}
+
+RefereeCommand ParseCommand(const string& _line)
+{
+	RefereeCommand command;
+	istringstream stream(_line);
+	string thrust;
+	stream >> command.m_targetX >> command.m_targetY >> thrust;
+	if (thrust == "BOOST") command.m_useBoost = true;
+	else if (thrust == "SHIELD") command.m_useShield = true;
+	else command.m_thrust = atoi(thrust.c_str());
+	return command;
+}
+
+// Sends the input after the delivery jitter and waits for the answer, returns false when the bot never answered.
+// The latency counts from the start of the turn clock, the jitter is part of it like in the arena.
+bool PlayTurn(BotProcess& _bot, const string& _input, bool _isFirstTurn, const RunnerOptions& _options, mt19937& _generator,
+	BuildStatistics* _statistics, array<RefereeCommand, REFEREE_POD_PER_PLAYER>* _commands)
+{
+	auto startTime = high_resolution_clock::now();
+	if (_options.m_jitter > 0) this_thread::sleep_for(microseconds(_generator() % (unsigned int)(_options.m_jitter * 1000 + 1)));
+	if (false == _bot.Write(_input)) return false;
+
+	const int limit = _isFirstTurn ? RUNNER_FIRST_TURN_LIMIT : RUNNER_TURN_LIMIT;
+	auto deadline = startTime + milliseconds(limit + RUNNER_KILL_DELAY);
+	for (int iPod = 0; iPod < REFEREE_POD_PER_PLAYER; iPod++)
+	{
+		string line;
+		if (false == _bot.ReadLine(&line, deadline)) return false;
+		(*_commands)[iPod] = ParseCommand(line);
+	}
+
+	double latency = duration_cast<microseconds>(high_resolution_clock::now() - startTime).count() / 1000.0;
+	if (_isFirstTurn)
+	{
+		_statistics->m_firstTurnLatencies.push_back(latency);
+		if (latency > limit) _statistics->m_firstTurnTimeouts++;
+	}
+	else
+	{
+		_statistics->m_latencies.push_back(latency);
+		if (latency > limit) _statistics->m_timeouts++;
+	}
+	return true;
+}
+
+// Returns the winning player, -1 on a draw, RUNNER_GAME_NOT_PLAYED when a bot could not be started
+int PlayGame(const array<string, REFEREE_PLAYER_NB>& _bots, int _mapIndex, unsigned int _seed, const RunnerOptions& _options,
+	QuotaThrottler* _throttler, map<string, BuildStatistics>* _statistics)
+{
+	Referee referee;
+	referee.Initialize(_mapIndex, _seed);
+	mt19937 generator(_seed);
+
+	array<BotProcess, REFEREE_PLAYER_NB> bots;
+	vector<pid_t> pids;
+	for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+	{
+		if (false == bots[iPlayer].Start(_bots[iPlayer], _options.m_cpu))
+		{
+			cerr << "Could not start " << _bots[iPlayer] << endl;
+			for (BotProcess& bot : bots) bot.Stop();
+			return RUNNER_GAME_NOT_PLAYED;
+		}
+		pids.push_back(bots[iPlayer].GetPid());
+	}
+	_throttler->AddBots(pids);
+
+	int winner = -1;
+	array<bool, REFEREE_PLAYER_NB> isAnswering = { true, true };
+	while (false == referee.IsOver())
+	{
+		const bool isFirstTurn = referee.GetTurn() == 0;
+		array<array<RefereeCommand, REFEREE_POD_PER_PLAYER>, REFEREE_PLAYER_NB> commands;
+		for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+		{
+			string input = FormatTurnInput(referee.GetPodsInputs(iPlayer));
+			if (isFirstTurn) input = FormatMapInput(referee) + input;
+			BuildStatistics& statistics = (*_statistics)[_bots[iPlayer]];
+			isAnswering[iPlayer] = PlayTurn(bots[iPlayer], input, isFirstTurn, _options, generator, &statistics, &commands[iPlayer]);
+			if (false == isAnswering[iPlayer]) statistics.m_missingAnswers++;
+		}
+
+		// A bot that stopped answering loses, like a timeout in the arena
+		if (false == isAnswering[0] || false == isAnswering[1])
+		{
+			if (isAnswering[0] != isAnswering[1]) winner = isAnswering[0] ? 0 : 1;
+			break;
+		}
+		referee.PlayTurn(commands[0], commands[1]);
+		winner = referee.GetWinner();
+	}
+
+	_throttler->RemoveBots(pids);
+	for (BotProcess& bot : bots) bot.Stop();
+	return winner;
+}
+
+#pragma endregion
+
+#pragma region Ratings
+
+struct PairResult
+{
+	int m_wins = 0; // Of the first build of the pair
+	int m_losses = 0;
+	int m_draws = 0;
+
+	int GetGames() const { return m_wins + m_losses + m_draws; }
+	double GetScore() const { return GetGames() > 0 ? (m_wins + 0.5 * m_draws) / GetGames() : 0.5; }
+	double GetScoreVariance() const;
+};
+
+// Variance of the score of a single game, draws count as half a win
+double PairResult::GetScoreVariance() const
+{
+	if (GetGames() == 0) return 0.0;
+	const double score = GetScore();
+	return (m_wins * (1.0 - score) * (1.0 - score) + m_losses * score * score + m_draws * (0.5 - score) * (0.5 - score)) / GetGames();
+}
+
+double ScoreFromElo(double _elo)
+{
+	return 1.0 / (1.0 + pow(10.0, -_elo / RATINGS_ELO_SCALE));
+}
+
+double EloFromScore(double _score)
+{
+	_score = clamp(_score, 0.001, 0.999);
+	return -RATINGS_ELO_SCALE * log10(1.0 / _score - 1.0);
+}
+
+// Half width of the 95% confidence interval of the Elo difference, from the spread of the game scores
+double ComputeEloError(const PairResult& _result)
+{
+	if (_result.GetGames() < 2) return RATINGS_UNKNOWN_ERROR;
+	const double score = clamp(_result.GetScore(), 0.001, 0.999);
+	const double scoreError = sqrt(_result.GetScoreVariance() / _result.GetGames());
+	return RATINGS_CONFIDENCE * scoreError * RATINGS_ELO_SCALE / (log(10.0) * score * (1.0 - score));
+}
+
+// Generalized sequential probability ratio test on the win, draw and loss results, H0 is elo0 and H1 is elo1
+double ComputeLogLikelihoodRatio(const PairResult& _result, double _elo0, double _elo1)
+{
+	const double variance = _result.GetScoreVariance();
+	if (_result.GetGames() < 2 || variance <= 0.0) return 0.0;
+	const double score0 = ScoreFromElo(_elo0);
+	const double score1 = ScoreFromElo(_elo1);
+	return _result.GetGames() * (score1 - score0) * (2.0 * _result.GetScore() - score0 - score1) / (2.0 * variance);
+}
+
+// Every game between the builds, rated with a Bradley-Terry model fitted by minorization-maximization
+class Ratings
+{
+public:
+
+	int AddBuild(const string& _build);
+	void AddResult(const string& _build0, const string& _build1, double _score);
+	void Compute();
+
+	int GetBuildCount() const { return (int)m_builds.size(); }
+	const string& GetBuild(int _index) const { return m_builds[_index]; }
+	int GetGames(int _index) const;
+	double GetElo(int _index) const { return m_elos[_index]; }
+	double GetError(int _index) const { return m_errors[_index]; }
+	double GetExpectedScore(int _index0, int _index1) const { return ScoreFromElo(m_elos[_index0] - m_elos[_index1]); }
+	PairResult GetPairResult(int _index0, int _index1) const;
+
+private:
+
+	vector<string> m_builds;
+	map<string, int> m_indices;
+	map<pair<int, int>, PairResult> m_results; // The first index is the smallest
+	vector<double> m_elos;
+	vector<double> m_errors; // Half width of the 95% confidence interval
+};
+
+int Ratings::AddBuild(const string& _build)
+{
+	auto found = m_indices.find(_build);
+	if (found != m_indices.end()) return found->second;
+	m_indices[_build] = (int)m_builds.size();
+	m_builds.push_back(_build);
+	m_elos.push_back(0.0);
+	m_errors.push_back(RATINGS_UNKNOWN_ERROR);
+	return (int)m_builds.size() - 1;
+}
+
+// The score is the one of the first build, 1 for a win, 0.5 for a draw
+void Ratings::AddResult(const string& _build0, const string& _build1, double _score)
+{
+	int index0 = AddBuild(_build0);
+	int index1 = AddBuild(_build1);
+	if (index0 == index1) return;
+	if (index0 > index1)
+	{
+		swap(index0, index1);
+		_score = 1.0 - _score;
+	}
+	PairResult& result = m_results[{ index0, index1 }];
+	if (_score > 0.75) result.m_wins++;
+	else if (_score < 0.25) result.m_losses++;
+	else result.m_draws++;
+}
+
+int Ratings::GetGames(int _index) const
+{
+	int games = 0;
+	for (const auto& result : m_results)
+	{
+		if (result.first.first == _index || result.first.second == _index) games += result.second.GetGames();
+	}
+	return games;
+}
+
+PairResult Ratings::GetPairResult(int _index0, int _index1) const
+{
+	auto found = m_results.find({ min(_index0, _index1), max(_index0, _index1) });
+	if (found == m_results.end()) return PairResult();
+	PairResult result = found->second;
+	if (_index0 > _index1) swap(result.m_wins, result.m_losses);
+	return result;
+}
+
+void Ratings::Compute()
+{
+	const int nbBuild = GetBuildCount();
+
+	// One virtual draw per pair keeps a build that never lost, or never won, at a finite rating
+	vector<double> scores(nbBuild, 0.0);
+	for (const auto& result : m_results)
+	{
+		scores[result.first.first] += result.second.m_wins + 0.5 * result.second.m_draws + 0.5;
+		scores[result.first.second] += result.second.m_losses + 0.5 * result.second.m_draws + 0.5;
+	}
+
+	vector<double> strengths(nbBuild, 1.0);
+	for (int iIteration = 0; iIteration < RATINGS_ITERATION_NB; iIteration++)
+	{
+		vector<double> denominators(nbBuild, 0.0);
+		for (const auto& result : m_results)
+		{
+			const int index0 = result.first.first;
+			const int index1 = result.first.second;
+			const double term = (result.second.GetGames() + 1.0) / (strengths[index0] + strengths[index1]);
+			denominators[index0] += term;
+			denominators[index1] += term;
+		}
+		double logSum = 0.0;
+		for (int iBuild = 0; iBuild < nbBuild; iBuild++)
+		{
+			if (denominators[iBuild] > 0.0) strengths[iBuild] = scores[iBuild] / denominators[iBuild];
+			logSum += log(strengths[iBuild]);
+		}
+		const double mean = exp(logSum / nbBuild); // The ratings average to 0
+		for (double& strength : strengths) strength /= mean;
+	}
+
+	// The error comes from the Fisher information of the games each build played
+	vector<double> informations(nbBuild, 0.0);
+	for (const auto& result : m_results)
+	{
+		const int index0 = result.first.first;
+		const int index1 = result.first.second;
+		const double expectedScore = strengths[index0] / (strengths[index0] + strengths[index1]);
+		const double information = result.second.GetGames() * expectedScore * (1.0 - expectedScore);
+		informations[index0] += information;
+		informations[index1] += information;
+	}
+	for (int iBuild = 0; iBuild < nbBuild; iBuild++)
+	{
+		m_elos[iBuild] = RATINGS_ELO_SCALE * log10(strengths[iBuild]);
+		m_errors[iBuild] = informations[iBuild] > 0.0
+			? min(RATINGS_CONFIDENCE * RATINGS_ELO_SCALE / log(10.0) / sqrt(informations[iBuild]), RATINGS_UNKNOWN_ERROR)
+			: RATINGS_UNKNOWN_ERROR;
+	}
+}
+
+#pragma endregion
+
+#pragma region Session
+
+// Plays matches on several threads, a match is two games on the same map and seed with the sides swapped.
+// With two builds it is a head to head, stopped by the SPRT when asked. With more builds, every match goes to the pair
+// whose result is the most uncertain.
+class Session
+{
+public:
+
+	bool Start(const RunnerOptions& _options, const vector<string>& _builds);
+	void Run();
+	void PrintReport() const;
+
+private:
+
+	void RunWorker();
+	array<int, REFEREE_PLAYER_NB> SelectPair() const;
+	void RecordGame(const array<string, REFEREE_PLAYER_NB>& _bots, int _winner);
+	void PrintProgress(const array<int, REFEREE_PLAYER_NB>& _pair);
+
+	RunnerOptions m_options;
+	vector<int> m_builds; // Indices in the ratings of the builds playing in this session
+	Ratings m_ratings;
+	map<pair<int, int>, int> m_pendingMatches;
+	map<string, BuildStatistics> m_statistics;
+	QuotaThrottler m_throttler;
+	ofstream m_resultsFile;
+	mutex m_mutex;
+	int m_nbMatchStarted = 0;
+	int m_nbGamePlayed = 0;
+	int m_nbDraw = 0;
+	int m_nbGameNotPlayed = 0;
+	bool m_isOver = false;
+};
+
+// Loads the stored results, false when the file cannot be written
+bool Session::Start(const RunnerOptions& _options, const vector<string>& _builds)
+{
+	m_options = _options;
+	for (const string& build : _builds) m_builds.push_back(m_ratings.AddBuild(build));
+
+	if (false == m_options.m_resultsPath.empty())
+	{
+		ifstream file(m_options.m_resultsPath);
+		string line;
+		while (getline(file, line))
+		{
+			istringstream stream(line);
+			string score, build0, build1;
+			if (getline(stream, score, '\t') && getline(stream, build0, '\t') && getline(stream, build1))
+			{
+				m_ratings.AddResult(build0, build1, atof(score.c_str()));
+			}
+		}
+		m_resultsFile.open(m_options.m_resultsPath, ios::app);
+		if (false == m_resultsFile.is_open()) return false;
+	}
+	m_ratings.Compute();
+	return true;
+}
+
+void Session::Run()
+{
+	BusyThreads busyThreads;
+	busyThreads.Start(m_options.m_busyThreads, m_options.m_cpu);
+	m_throttler.Start(m_options.m_quota, m_options.m_quotaPeriod);
+
+	vector<thread> workers;
+	for (int iThread = 0; iThread < m_options.m_threads; iThread++) workers.emplace_back(&Session::RunWorker, this);
+	for (thread& worker : workers) worker.join();
+
+	m_throttler.Stop();
+	busyThreads.Stop();
+}
+
+void Session::RunWorker()
+{
+	for (;;)
+	{
+		array<int, REFEREE_PLAYER_NB> pair;
+		int matchIndex = 0;
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (m_isOver || m_nbMatchStarted * 2 >= m_options.m_games) return;
+			pair = SelectPair();
+			matchIndex = m_nbMatchStarted++;
+			m_pendingMatches[{ pair[0], pair[1] }]++;
+		}
+
+		// Both sides play the same map and seed, so both builds see both starting positions
+		const int gameIndex = matchIndex * 2;
+		const unsigned int seed = m_options.m_seed + (unsigned int)gameIndex * 7919u;
+		array<string, REFEREE_PLAYER_NB> bots = { m_ratings.GetBuild(pair[0]), m_ratings.GetBuild(pair[1]) };
+		map<string, BuildStatistics> statistics;
+		array<int, REFEREE_PLAYER_NB> winners;
+		winners[0] = PlayGame(bots, gameIndex % Referee::GetMapCount(), seed, m_options, &m_throttler, &statistics);
+		swap(bots[0], bots[1]);
+		winners[1] = PlayGame(bots, gameIndex % Referee::GetMapCount(), seed, m_options, &m_throttler, &statistics);
+
+		lock_guard<mutex> lock(m_mutex);
+		m_pendingMatches[{ pair[0], pair[1] }]--;
+		RecordGame(bots, winners[1]);
+		swap(bots[0], bots[1]);
+		RecordGame(bots, winners[0]);
+		for (const auto& buildStatistics : statistics) m_statistics[buildStatistics.first].Merge(buildStatistics.second);
+		m_ratings.Compute();
+		if (false == m_isOver) PrintProgress(pair);
+	}
+}
+
+// The pair whose next game teaches the most, games between close builds with uncertain ratings
+array<int, REFEREE_PLAYER_NB> Session::SelectPair() const
+{
+	array<int, REFEREE_PLAYER_NB> bestPair = { m_builds[0], m_builds[0] };
+	double bestUncertainty = -1.0;
+	for (size_t iBuild = 0; iBuild < m_builds.size(); iBuild++)
+	{
+		for (size_t iOpponent = iBuild + 1; iOpponent < m_builds.size(); iOpponent++)
+		{
+			const int index0 = m_builds[iBuild];
+			const int index1 = m_builds[iOpponent];
+			const double expectedScore = m_ratings.GetExpectedScore(index0, index1);
+			auto pending = m_pendingMatches.find({ index0, index1 });
+			const int nbPending = pending != m_pendingMatches.end() ? pending->second : 0;
+			const double uncertainty = (m_ratings.GetError(index0) + m_ratings.GetError(index1)) * expectedScore * (1.0 - expectedScore) / (1 + nbPending);
+			if (uncertainty > bestUncertainty)
+			{
+				bestUncertainty = uncertainty;
+				bestPair = { index0, index1 };
+			}
+		}
+	}
+	return bestPair;
+}
+
+void Session::RecordGame(const array<string, REFEREE_PLAYER_NB>& _bots, int _winner)
+{
+	if (_winner == RUNNER_GAME_NOT_PLAYED)
+	{
+		m_nbGameNotPlayed++;
+		return;
+	}
+	m_nbGamePlayed++;
+	if (_winner < 0) m_nbDraw++;
+	const double score = _winner < 0 ? 0.5 : (_winner == 0 ? 1.0 : 0.0);
+	if (_bots[0] == _bots[1]) return;
+	m_ratings.AddResult(_bots[0], _bots[1], score);
+	if (m_resultsFile.is_open()) m_resultsFile << score << "\t" << _bots[0] << "\t" << _bots[1] << endl;
+}
+
+void Session::PrintProgress(const array<int, REFEREE_PLAYER_NB>& _pair)
+{
+	cout << "Games " << m_nbGamePlayed;
+	if (_pair[0] == _pair[1])
+	{
+		cout << "  draws " << m_nbDraw << endl;
+		return;
+	}
+
+	const PairResult result = m_ratings.GetPairResult(_pair[0], _pair[1]);
+	cout << fixed << setprecision(1) << "  " << m_ratings.GetBuild(_pair[0]) << " against " << m_ratings.GetBuild(_pair[1])
+		<< "  W-L-D " << result.m_wins << "-" << result.m_losses << "-" << result.m_draws
+		<< "  Elo " << EloFromScore(result.GetScore()) << " +- " << ComputeEloError(result);
+	if (m_options.m_isSprt)
+	{
+		const double lowerBound = log(m_options.m_beta / (1.0 - m_options.m_alpha));
+		const double upperBound = log((1.0 - m_options.m_beta) / m_options.m_alpha);
+		const double logLikelihoodRatio = ComputeLogLikelihoodRatio(result, m_options.m_elo0, m_options.m_elo1);
+		cout << setprecision(2) << "  LLR " << logLikelihoodRatio << " [" << lowerBound << ", " << upperBound << "]";
+		if (logLikelihoodRatio >= upperBound || logLikelihoodRatio <= lowerBound)
+		{
+			m_isOver = true; // The matches in progress are still recorded
+			cout << endl << "SPRT over : " << (logLikelihoodRatio >= upperBound ? "H1" : "H0") << " accepted, the Elo difference is "
+				<< (logLikelihoodRatio >= upperBound ? "at least " : "at most ") << setprecision(1)
+				<< (logLikelihoodRatio >= upperBound ? m_options.m_elo1 : m_options.m_elo0);
+		}
+	}
+	cout << endl;
+}
+
+void Session::PrintReport() const
+{
+	cout << m_nbGamePlayed << " games played, " << m_nbDraw << " draws, " << m_nbGameNotPlayed << " not played because a bot could not be started" << endl;
+
+	if (m_ratings.GetBuildCount() > 1)
+	{
+		vector<int> ranking(m_ratings.GetBuildCount());
+		for (int iBuild = 0; iBuild < m_ratings.GetBuildCount(); iBuild++) ranking[iBuild] = iBuild;
+		sort(ranking.begin(), ranking.end(), [this](int _index0, int _index1) { return m_ratings.GetElo(_index0) > m_ratings.GetElo(_index1); });
+		cout << "Ratings over every stored game" << endl;
+		for (int index : ranking)
+		{
+			cout << fixed << setprecision(1) << setw(8) << m_ratings.GetElo(index) << " +- " << setw(6) << m_ratings.GetError(index)
+				<< setw(7) << m_ratings.GetGames(index) << " games  " << m_ratings.GetBuild(index) << endl;
+		}
+	}
+
+	for (const auto& buildStatistics : m_statistics) PrintStatistics(buildStatistics.first, buildStatistics.second);
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	RunnerOptions options;
+	options.m_threads = max((int)thread::hardware_concurrency() / REFEREE_PLAYER_NB, 1);
+	vector<string> bots;
+	for (int iArgument = 1; iArgument < _argc; iArgument++)
+	{
+		const string argument = _argv[iArgument];
+		const bool hasValue = iArgument + 1 < _argc;
+		if (argument == "--games" && hasValue) options.m_games = max(atoi(_argv[++iArgument]), 1);
+		else if (argument == "--threads" && hasValue) options.m_threads = max(atoi(_argv[++iArgument]), 1);
+		else if (argument == "--busy" && hasValue) options.m_busyThreads = max(atoi(_argv[++iArgument]), 0);
+		else if (argument == "--quota" && hasValue) options.m_quota = clamp(atoi(_argv[++iArgument]), 1, 100);
+		else if (argument == "--period" && hasValue) options.m_quotaPeriod = max(atoi(_argv[++iArgument]), 1);
+		else if (argument == "--jitter" && hasValue) options.m_jitter = max(atoi(_argv[++iArgument]), 0);
+		else if (argument == "--cpu" && hasValue) options.m_cpu = atoi(_argv[++iArgument]);
+		else if (argument == "--seed" && hasValue) options.m_seed = (unsigned int)atoi(_argv[++iArgument]);
+		else if (argument == "--results" && hasValue) options.m_resultsPath = _argv[++iArgument];
+		else if (argument == "--sprt" && iArgument + 2 < _argc)
+		{
+			options.m_isSprt = true;
+			options.m_elo0 = atof(_argv[++iArgument]);
+			options.m_elo1 = atof(_argv[++iArgument]);
+		}
+		else if (argument == "--alpha" && hasValue) options.m_alpha = clamp(atof(_argv[++iArgument]), 0.001, 0.5);
+		else if (argument == "--beta" && hasValue) options.m_beta = clamp(atof(_argv[++iArgument]), 0.001, 0.5);
+		else if (find(bots.begin(), bots.end(), argument) == bots.end()) bots.push_back(argument);
+	}
+	if (bots.empty() && options.m_resultsPath.empty())
+	{
+		cout << "Usage : MatchRunner [--games n] [--threads n] [--busy threads] [--quota percent] [--period ms] [--jitter ms] [--cpu index] [--seed s]"
+			" [--results file] [--sprt elo0 elo1] [--alpha a] [--beta b] [bot...]" << endl;
+		return 1;
+	}
+	if (options.m_isSprt && bots.size() != 2)
+	{
+		cout << "The SPRT compares exactly two builds" << endl;
+		return 1;
+	}
+	signal(SIGPIPE, SIG_IGN); // A dead bot is detected by the failed write instead
+
+	Session session;
+	if (false == session.Start(options, bots))
+	{
+		cout << "Could not open " << options.m_resultsPath << endl;
+		return 1;
+	}
+	if (false == bots.empty())
+	{
+		cout << "Playing up to " << options.m_games << " games between " << bots.size() << " builds on " << options.m_threads
+			<< " threads with " << options.m_busyThreads << " busy threads, a quota of " << options.m_quota << "% of " << options.m_quotaPeriod
+			<< "ms and up to " << options.m_jitter << "ms of input jitter" << endl;
+		session.Run();
+	}
+	session.PrintReport();
+}
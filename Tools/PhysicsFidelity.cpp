@@ -0,0 +1,324 @@
+// Replays recorded referee transitions through the Simulation of Gold.cpp and measures how far it drifts.
+// Build : g++ -std=c++17 -O2 -pthread Tools/PhysicsFidelity.cpp Tools/Referee.cpp -o PhysicsFidelity
+// Usage : PhysicsFidelity [games] [millisecondsPerTurn] [framesFile]   records self-play games, saved to the frames file when given
+//         PhysicsFidelity --replay framesFile                           replays frames recorded before, without playing
+//         PhysicsFidelity --import transcript...                        replays arena games, see ImportArenaGame
+// Every pod of every turn is simulated from its exact state before the turn, so the errors never add up over a game.
+// Self-play frames come from Tools/Referee.cpp, a rewrite of the rules : they measure the Simulation against that rewrite,
+// only imported arena games measure it against the real referee. Their angles are rounded by the inputs.
+
+#define GOLD_NO_MAIN
+#define GOLD_SILENT
+#include "../Gold.cpp"
+
+#include "Referee.h"
+#include "GoldPlayer.h"
+#include "RecordedGames.h"
+
+#include <iomanip>
+
+#define FIDELITY_DEFAULT_GAMES 4
+#define FIDELITY_DEFAULT_MILLISECONDS_PER_TURN 2
+
+// A pod diverges when one of its fields is further than this from the referee
+#define FIDELITY_POSITION_TOLERANCE 1.0
+#define FIDELITY_SPEED_TOLERANCE 1.0
+#define FIDELITY_ANGLE_TOLERANCE 1.0
+
+#pragma region Error Report
+
+struct ErrorDistribution
+{
+	vector<double> m_errors;
+
+	void Add(double _error) { m_errors.push_back(_error); }
+	void Print(const string& _name, const string& _unit) const;
+};
+
+void ErrorDistribution::Print(const string& _name, const string& _unit) const
+{
+	if (m_errors.empty()) return;
+	vector<double> errors = m_errors;
+	sort(errors.begin(), errors.end());
+
+	double sum = 0.0;
+	int nonZeroCount = 0;
+	for (double error : errors)
+	{
+		sum += error;
+		if (error > 0.0) nonZeroCount++;
+	}
+	auto percentile = [&](double _ratio) { return errors[min(errors.size() - 1, (size_t)(_ratio * errors.size()))]; };
+
+	cout << left << setw(12) << _name << right << fixed << setprecision(2)
+		<< " nonzero " << setw(6) << 100.0 * nonZeroCount / errors.size() << "%"
+		<< "  mean " << setw(8) << sum / errors.size()
+		<< "  p50 " << setw(8) << percentile(0.5)
+		<< "  p90 " << setw(8) << percentile(0.9)
+		<< "  p99 " << setw(8) << percentile(0.99)
+		<< "  max " << setw(8) << errors.back() << " " << _unit << endl;
+}
+
+// Most likely cause of a divergence, the first one that applies is kept
+enum DivergenceCategory
+{
+	DIVERGENCE_COLLISION, // The referee pods could touch
+	DIVERGENCE_FALSE_COLLISION, // Only the Simulation bounced
+	DIVERGENCE_BOOST,
+	DIVERGENCE_SHIELD,
+	DIVERGENCE_CHECKPOINT,
+	DIVERGENCE_ROUNDING,
+	DIVERGENCE_COUNT,
+};
+
+const char* DIVERGENCE_NAMES[DIVERGENCE_COUNT] = { "collision", "sim bounce", "boost", "shield", "checkpoint", "rounding" };
+
+struct FidelityReport
+{
+	ErrorDistribution m_position;
+	ErrorDistribution m_speed;
+	ErrorDistribution m_angle;
+	int m_checkpointMismatches = 0;
+	int m_podTransitions = 0;
+	array<int, DIVERGENCE_COUNT> m_divergences = {};
+	array<double, DIVERGENCE_COUNT> m_divergencePositionErrors = {};
+
+	// Output quantisation : a rotation sent through an integer target point and turned by the referee
+	ErrorDistribution m_quantisation;
+	int m_quantisedRotations = 0;
+	int m_quantisationMismatches = 0;
+};
+
+#pragma endregion
+
+#pragma region Replay
+
+double AngleDifference(double _a, double _b)
+{
+	double difference = fmod(fabs(_a - _b), 360.0);
+	return min(difference, 360.0 - difference);
+}
+
+// Whether the referee pod could touch another pod during the turn, once every command has been applied
+bool CanCollide(const array<RefereePod, REFEREE_POD_TOTAL_NB>& _pods, int _podIndex)
+{
+	const RefereePod& pod = _pods[_podIndex];
+	for (int iOtherPod = 0; iOtherPod < REFEREE_POD_TOTAL_NB; iOtherPod++)
+	{
+		if (iOtherPod == _podIndex) continue;
+		const RefereePod& otherPod = _pods[iOtherPod];
+
+		// Closest distance of the two straight lines over the turn
+		double positionX = otherPod.m_x - pod.m_x;
+		double positionY = otherPod.m_y - pod.m_y;
+		double speedX = otherPod.m_speedX - pod.m_speedX;
+		double speedY = otherPod.m_speedY - pod.m_speedY;
+		double squareSpeed = speedX * speedX + speedY * speedY;
+		double time = squareSpeed > 0.0 ? clamp(-(positionX * speedX + positionY * speedY) / squareSpeed, 0.0, 1.0) : 0.0;
+		double closestX = positionX + speedX * time;
+		double closestY = positionY + speedY * time;
+		if (closestX * closestX + closestY * closestY <= 4.0 * REFEREE_POD_RADIUS * REFEREE_POD_RADIUS) return true;
+	}
+	return false;
+}
+
+// Replays the frame from the point of view of one player, only its pods go through the moves of the Simulation.
+// The opponent pods are given the speed and mass the referee gave them, the bot can not know their commands.
+void ReplayFrame(const RecordedFrame& _frame, int _turn, int _player, Simulation& _simulation, FidelityReport* _report)
+{
+	array<RefereePod, REFEREE_POD_TOTAL_NB> podsBefore;
+	array<RefereePod, REFEREE_POD_TOTAL_NB> podsCommanded; // After the rotation and the thrust of the referee
+	array<RefereeCommand, REFEREE_POD_TOTAL_NB> commands;
+	array<RefereePod, REFEREE_POD_TOTAL_NB> podsAfter;
+	array<PodInput, POD_TOTAL_NB> inputs;
+	for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+	{
+		const int recordedIndex = (iPod + _player * REFEREE_POD_PER_PLAYER) % REFEREE_POD_TOTAL_NB;
+		podsBefore[iPod] = _frame.m_podsBefore[recordedIndex];
+		commands[iPod] = _frame.m_commands[recordedIndex];
+		podsAfter[iPod] = _frame.m_podsAfter[recordedIndex];
+		podsCommanded[iPod] = podsBefore[iPod];
+		Referee::ApplyCommand(podsCommanded[iPod], commands[iPod]);
+		inputs[iPod] = CreatePodInput(podsBefore[iPod]);
+	}
+
+	_simulation.ApplyPodsInputs(inputs, _turn == 0);
+	array<Move, POD_NB_TO_SIMULATE> moves;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		Pod& pod = _simulation.m_pods[iPod];
+		pod.m_currentCheckpointIndex = podsBefore[iPod].m_nextCheckpointIndex;
+		pod.m_checkpointPassedCount = podsBefore[iPod].m_checkpointPassedCount;
+		pod.m_usedBoost = podsBefore[iPod].m_usedBoost;
+		pod.m_shieldCooldown = podsBefore[iPod].m_shieldCooldown;
+		pod.m_isUsingShield = false;
+
+		if (iPod < POD_NB_TO_SIMULATE)
+		{
+			// The move is the rotation the referee actually applied, the quantisation is measured on its own
+			Move& move = moves[iPod];
+			move.m_rotation = (int)round(fmod(round(podsCommanded[iPod].m_angle) - pod.m_angle + 540.0, 360.0) - 180.0);
+			move.m_thrust = clamp(commands[iPod].m_thrust, 0, 100);
+			move.m_useBoost = commands[iPod].m_useBoost;
+			move.m_useShield = commands[iPod].m_useShield;
+		}
+		else
+		{
+			pod.m_speed = Vector2((float)podsCommanded[iPod].m_speedX, (float)podsCommanded[iPod].m_speedY);
+			pod.m_angle = (int)round(podsCommanded[iPod].m_angle) % 360;
+			pod.m_isUsingShield = podsCommanded[iPod].m_mass > 1.0;
+		}
+	}
+
+	_simulation.m_tempPods = _simulation.m_pods;
+	_simulation.SimulateTurn(moves);
+
+	for (int iPod = 0; iPod < POD_NB_TO_SIMULATE; iPod++)
+	{
+		const Pod& pod = _simulation.m_tempPods[iPod];
+		const RefereePod& expected = podsAfter[iPod];
+
+		double positionError = hypot(pod.m_position.m_x - expected.m_x, pod.m_position.m_y - expected.m_y);
+		double speedError = hypot(pod.m_speed.m_x - expected.m_speedX, pod.m_speed.m_y - expected.m_speedY);
+		double angleError = AngleDifference(pod.m_angle, expected.m_angle);
+		bool isCheckpointMismatch = pod.m_currentCheckpointIndex != expected.m_nextCheckpointIndex;
+
+		_report->m_position.Add(positionError);
+		_report->m_speed.Add(speedError);
+		_report->m_angle.Add(angleError);
+		if (isCheckpointMismatch) _report->m_checkpointMismatches++;
+		_report->m_podTransitions++;
+
+		bool isDiverging = isCheckpointMismatch || positionError > FIDELITY_POSITION_TOLERANCE
+			|| speedError > FIDELITY_SPEED_TOLERANCE || angleError > FIDELITY_ANGLE_TOLERANCE;
+		if (false == isDiverging) continue;
+
+		DivergenceCategory category = DIVERGENCE_ROUNDING;
+		if (CanCollide(podsCommanded, iPod)) category = DIVERGENCE_COLLISION;
+		else if (_simulation.HasCollided()) category = DIVERGENCE_FALSE_COLLISION;
+		else if (commands[iPod].m_useBoost) category = DIVERGENCE_BOOST;
+		else if (commands[iPod].m_useShield || podsBefore[iPod].m_shieldCooldown > 0) category = DIVERGENCE_SHIELD;
+		else if (isCheckpointMismatch) category = DIVERGENCE_CHECKPOINT;
+		_report->m_divergences[category]++;
+		_report->m_divergencePositionErrors[category] += positionError;
+	}
+}
+
+// Sends every rotation through ComputeOutputsFromMoves and the integer target of the referee command
+void MeasureQuantisation(const RefereePod& _refereePod, Simulation& _simulation, FidelityReport* _report)
+{
+	if (_refereePod.m_angle < 0.0) return; // The first turn has no rotation limit
+
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		Pod& pod = _simulation.m_pods[iPod];
+		pod.m_position = Vector2((float)_refereePod.m_x, (float)_refereePod.m_y);
+		pod.m_angle = (int)_refereePod.m_angle;
+	}
+
+	for (int rotation = -(int)POD_MAXIMUM_ROTATION; rotation <= (int)POD_MAXIMUM_ROTATION; rotation++)
+	{
+		array<Move, POD_NB_TO_SIMULATE> moves;
+		moves[0].m_rotation = rotation;
+		array<PodOutput, POD_CONTROLLABLE_NB> outputs = _simulation.ComputeOutputsFromMoves(moves);
+
+		// Same conversion as GoldPlayer and the stream adapter
+		RefereeCommand command;
+		command.m_targetX = (int)outputs[0].m_target.m_x;
+		command.m_targetY = (int)outputs[0].m_target.m_y;
+		RefereePod refereePod = _refereePod;
+		Referee::ApplyCommand(refereePod, command);
+
+		double error = AngleDifference(round(refereePod.m_angle), _refereePod.m_angle + rotation);
+		_report->m_quantisation.Add(error);
+		_report->m_quantisedRotations++;
+		if (error > 0.0) _report->m_quantisationMismatches++;
+	}
+}
+
+void ReplayGame(const RecordedGame& _game, FidelityReport* _report)
+{
+	Simulation simulation;
+	vector<Vector2> checkpointPositions;
+	for (const RefereePoint& checkpoint : _game.m_checkpoints) checkpointPositions.push_back(Vector2((float)checkpoint.m_x, (float)checkpoint.m_y));
+	simulation.InitializeCheckpoints(_game.m_numberOfLaps, checkpointPositions);
+	simulation.m_useOpponentModels = false; // The opponents replay the commands of the referee
+
+	for (size_t iFrame = 0; iFrame < _game.m_frames.size(); iFrame++)
+	{
+		const RecordedFrame& frame = _game.m_frames[iFrame];
+		for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+		{
+			ReplayFrame(frame, (int)iFrame, iPlayer, simulation, _report);
+		}
+		for (const RefereePod& pod : frame.m_podsBefore) MeasureQuantisation(pod, simulation, _report);
+	}
+}
+
+void PrintReport(const FidelityReport& _report)
+{
+	cout << endl << "Per pod and turn errors of Simulation against the referee, " << _report.m_podTransitions << " pod transitions" << endl;
+	_report.m_position.Print("position", "units");
+	_report.m_speed.Print("speed", "units/turn");
+	_report.m_angle.Print("angle", "degrees");
+	cout << "checkpoint   mismatch " << fixed << setprecision(2) << 100.0 * _report.m_checkpointMismatches / max(_report.m_podTransitions, 1) << "%" << endl;
+
+	int divergenceCount = 0;
+	for (int count : _report.m_divergences) divergenceCount += count;
+	cout << endl << divergenceCount << " diverging transitions (" << 100.0 * divergenceCount / max(_report.m_podTransitions, 1) << "%)" << endl;
+	for (int iCategory = 0; iCategory < DIVERGENCE_COUNT; iCategory++)
+	{
+		const int count = _report.m_divergences[iCategory];
+		cout << "  " << left << setw(12) << DIVERGENCE_NAMES[iCategory] << right << setw(7) << count
+			<< "  mean position error " << (count > 0 ? _report.m_divergencePositionErrors[iCategory] / count : 0.0) << endl;
+	}
+
+	cout << endl << "Output quantisation at a target distance of " << TARGET_DISTANCE << ", " << _report.m_quantisedRotations << " rotations" << endl;
+	cout << "  heading changed on " << 100.0 * _report.m_quantisationMismatches / max(_report.m_quantisedRotations, 1) << "% of the rotations" << endl;
+	_report.m_quantisation.Print("  error", "degrees");
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	vector<RecordedGame> games;
+	if (_argc > 2 && string(_argv[1]) == "--replay")
+	{
+		games = ReadGames(_argv[2]);
+		cout << "Replaying " << games.size() << " games from " << _argv[2] << endl;
+	}
+	else if (_argc > 2 && string(_argv[1]) == "--import")
+	{
+		for (int iArgument = 2; iArgument < _argc; iArgument++)
+		{
+			ifstream file(_argv[iArgument]);
+			games.push_back(ImportArenaGame(file));
+			cout << "Imported " << games.back().m_frames.size() << " arena frames from " << _argv[iArgument] << endl;
+		}
+	}
+	else
+	{
+		const int gameCount = max(_argc > 1 ? atoi(_argv[1]) : FIDELITY_DEFAULT_GAMES, 1);
+		const int millisecondsPerTurn = _argc > 2 ? atoi(_argv[2]) : FIDELITY_DEFAULT_MILLISECONDS_PER_TURN;
+
+		SearchParameters parameters;
+		parameters.m_timeAllocatedPerTurn = millisecondsPerTurn;
+		parameters.m_mapAnalysisTime = MAP_ANALYSIS_TIME * millisecondsPerTurn / TIME_ALLOCATED_PER_TURN;
+
+		cout << "Recording " << gameCount << " self-play games at " << millisecondsPerTurn << "ms per turn" << endl;
+		for (int iGame = 0; iGame < gameCount; iGame++)
+		{
+			games.push_back(RecordGame(iGame % Referee::GetMapCount(), 1000u + (unsigned int)iGame * 7919u, parameters));
+		}
+		if (_argc > 3)
+		{
+			WriteGames(_argv[3], games);
+			cout << "Frames written to " << _argv[3] << endl;
+		}
+	}
+
+	FidelityReport report;
+	for (const RecordedGame& game : games) ReplayGame(game, &report);
+	PrintReport(report);
+}
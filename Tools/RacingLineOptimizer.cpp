@@ -0,0 +1,296 @@
+// Offline search of the racing lines and boost checkpoints of the arena layouts, baked into GoldRacingLines.h for Gold.cpp.
+// Build : g++ -std=c++17 -O2 -pthread Tools/RacingLineOptimizer.cpp Tools/Referee.cpp -o RacingLineOptimizer
+// Usage : RacingLineOptimizer [millisecondsPerTurn] [restartsPerMap] [outputHeader]
+// The defaults spend a few minutes per map and per thread: searched laps for the racing line, then a searched race
+// from every starting checkpoint for every boost checkpoint.
+// The output header is picked up by Gold.cpp when it sits next to it, paste its content in place of the empty table for the submission.
+
+#define GOLD_NO_MAIN
+#define GOLD_SILENT
+#include "../Gold.cpp"
+
+#include "Referee.h"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#define OPTIMIZER_DEFAULT_MILLISECONDS_PER_TURN 300
+#define OPTIMIZER_DEFAULT_RESTARTS 4
+#define OPTIMIZER_BOOST_SIMULATIONS 20000 // Simulated turns per turn of the boost races, deterministic unlike the clock
+#define OPTIMIZER_DEFAULT_OUTPUT "GoldRacingLines.h"
+#define OPTIMIZER_LAPS 2 // The racing line is taken on the last lap, once the pod is at full speed
+#define OPTIMIZER_MAXIMUM_OFFSET 500.0f // Keeps the points inside the checkpoints despite the moves of the arena
+
+#pragma region Racing Line Search
+
+struct RacingLineResult
+{
+	array<Vector2, CHECKPOINT_MAX_NB> m_offsets; // From the center of each checkpoint
+	int m_searchedLapTurns = MAP_ANALYSIS_MAXIMUM_TURNS;
+	int m_heuristicTurns = MAXIMUM_INT; // Heuristic laps from every starting checkpoint, following the racing line
+	bool m_isComplete = false;
+	array<int, CHECKPOINT_MAX_NB> m_boostCheckpointIndexes = {}; // For each starting checkpoint, negative when the boost is not kept for one
+};
+
+// The pod starts on the given checkpoint facing the next one, the other pods are out of the way
+Simulation CreateSoloSimulation(const vector<RefereePoint>& _checkpoints, int _startCheckpointIndex, int _numberOfLaps)
+{
+	const int checkpointCount = (int)_checkpoints.size();
+	vector<Vector2> checkpointPositions;
+	for (int iCheckpoint = 0; iCheckpoint < checkpointCount; iCheckpoint++)
+	{
+		const RefereePoint& checkpoint = _checkpoints[(iCheckpoint + _startCheckpointIndex) % checkpointCount];
+		checkpointPositions.push_back(Vector2((float)checkpoint.m_x, (float)checkpoint.m_y));
+	}
+
+	Simulation simulation;
+	simulation.InitializeCheckpoints(_numberOfLaps, checkpointPositions);
+	simulation.m_hasRacingLine = false; // Ignore the racing line of a previous run
+
+	array<PodInput, POD_TOTAL_NB> inputs;
+	for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+	{
+		inputs[iPod].m_x = (int)(-MAP_WIDTH * iPod);
+		inputs[iPod].m_y = (int)(-MAP_HEIGHT * iPod);
+		inputs[iPod].m_nextCheckpointIndex = 1;
+	}
+	inputs[0].m_x = (int)checkpointPositions[0].m_x;
+	inputs[0].m_y = (int)checkpointPositions[0].m_y;
+	simulation.ApplyPodsInputs(inputs, true);
+	return simulation;
+}
+
+// The offsets are given in the order of the layout, the simulation starts from one of its checkpoints
+void SetRacingLine(Simulation* _simulation, const array<Vector2, CHECKPOINT_MAX_NB>& _offsets, int _startCheckpointIndex)
+{
+	const int checkpointCount = _simulation->m_checkpointCount_Lap;
+	for (int iCheckpoint = 0; iCheckpoint < checkpointCount; iCheckpoint++)
+	{
+		_simulation->m_racingLine[iCheckpoint] = _simulation->m_checkpoints[iCheckpoint].m_position + _offsets[(iCheckpoint + _startCheckpointIndex) % checkpointCount];
+	}
+	_simulation->m_hasRacingLine = true;
+}
+
+// Sum of the heuristic laps from every starting checkpoint, the arena can start the race from any of them
+int ComputeHeuristicTurns(const vector<RefereePoint>& _checkpoints, const array<Vector2, CHECKPOINT_MAX_NB>* _offsets)
+{
+	const int checkpointCount = (int)_checkpoints.size();
+	int turns = 0;
+	for (int iStart = 0; iStart < checkpointCount; iStart++)
+	{
+		Simulation simulation = CreateSoloSimulation(_checkpoints, iStart, 1);
+		if (_offsets != nullptr) SetRacingLine(&simulation, *_offsets, iStart);
+		turns += MapAnalysis::ComputeHeuristicLapTurns(simulation);
+	}
+	return turns;
+}
+
+// Turns of a searched race from the given start, the boost kept for a checkpoint of the layout
+int ComputeBoostRaceTurns(const vector<RefereePoint>& _checkpoints, const array<Vector2, CHECKPOINT_MAX_NB>& _offsets, int _startCheckpointIndex, int _boostCheckpointIndex)
+{
+	const int checkpointCount = (int)_checkpoints.size();
+	Simulation simulation = CreateSoloSimulation(_checkpoints, _startCheckpointIndex, OPTIMIZER_LAPS);
+	SetRacingLine(&simulation, _offsets, _startCheckpointIndex);
+	simulation.m_pods[0].m_boostCheckpointIndex = _boostCheckpointIndex < 0 ? -1 : (_boostCheckpointIndex - _startCheckpointIndex + checkpointCount) % checkpointCount;
+
+	// Every candidate plays with the same seeds, so the races only differ by the boost
+	SearchParameters parameters;
+	parameters.m_simulationBudget = OPTIMIZER_BOOST_SIMULATIONS;
+	parameters.m_seed = 1000u + (unsigned int)_startCheckpointIndex * 7919u;
+	Solver solver(&simulation, parameters);
+
+	const int racePassedCount = checkpointCount * OPTIMIZER_LAPS;
+	int turn = 0;
+	while (simulation.m_pods[0].m_checkpointPassedCount < racePassedCount && turn < MAP_ANALYSIS_MAXIMUM_TURNS * OPTIMIZER_LAPS)
+	{
+		Random::SetSeed(parameters.m_seed + (unsigned int)turn * 7919u);
+		const Solution& solution = solver.Solve();
+		simulation.m_tempPods = simulation.m_pods;
+		simulation.SimulateTurn(solution.m_turns[0].m_moves);
+		simulation.m_pods = simulation.m_tempPods;
+		simulation.m_turn++;
+		turn++;
+	}
+	return turn;
+}
+
+// The boost checkpoint of the fastest race from this start, negative when boosting at the first chance is the fastest
+int SearchBoostCheckpoint(const vector<RefereePoint>& _checkpoints, const array<Vector2, CHECKPOINT_MAX_NB>& _offsets, int _startCheckpointIndex)
+{
+	int bestBoostCheckpointIndex = -1;
+	int bestTurns = ComputeBoostRaceTurns(_checkpoints, _offsets, _startCheckpointIndex, -1);
+	for (int iCheckpoint = 0; iCheckpoint < (int)_checkpoints.size(); iCheckpoint++)
+	{
+		int turns = ComputeBoostRaceTurns(_checkpoints, _offsets, _startCheckpointIndex, iCheckpoint);
+		if (turns < bestTurns)
+		{
+			bestTurns = turns;
+			bestBoostCheckpointIndex = iCheckpoint;
+		}
+	}
+	return bestBoostCheckpointIndex;
+}
+
+RacingLineResult SearchRacingLine(const vector<RefereePoint>& _checkpoints, int _millisecondsPerTurn, unsigned int _seed)
+{
+	Random::SetSeed(_seed);
+
+	RacingLineResult result;
+	Simulation simulation = CreateSoloSimulation(_checkpoints, 0, OPTIMIZER_LAPS);
+	SearchParameters parameters;
+	parameters.m_timeAllocatedPerTurn = _millisecondsPerTurn;
+	Solver solver(&simulation, parameters);
+
+	const int checkpointCount = simulation.m_checkpointCount_Lap;
+	const int lastLapPassedCount = checkpointCount * (OPTIMIZER_LAPS - 1);
+	const int racePassedCount = checkpointCount * OPTIMIZER_LAPS;
+	int nbCheckpointCrossed = 0;
+	int turn = 0;
+	int lastLapFirstTurn = 0;
+	while (simulation.m_pods[0].m_checkpointPassedCount < racePassedCount && turn < MAP_ANALYSIS_MAXIMUM_TURNS * OPTIMIZER_LAPS)
+	{
+		const Solution& solution = solver.Solve();
+
+		int checkpointIndex = simulation.m_pods[0].m_currentCheckpointIndex;
+		simulation.m_tempPods = simulation.m_pods;
+		simulation.SimulateTurn(solution.m_turns[0].m_moves);
+		simulation.m_pods = simulation.m_tempPods;
+		simulation.m_turn++;
+		turn++;
+
+		const Pod& pod = simulation.m_pods[0];
+		if (pod.m_currentCheckpointIndex == checkpointIndex) continue;
+		if (pod.m_checkpointPassedCount == lastLapPassedCount) lastLapFirstTurn = turn;
+		if (pod.m_checkpointPassedCount <= lastLapPassedCount) continue;
+
+		Vector2 offset = pod.m_position - simulation.m_checkpoints[checkpointIndex].m_position;
+		if (offset.Magnitude() > OPTIMIZER_MAXIMUM_OFFSET) offset = offset.Normalized() * OPTIMIZER_MAXIMUM_OFFSET;
+		result.m_offsets[checkpointIndex] = offset;
+		nbCheckpointCrossed++;
+	}
+
+	result.m_isComplete = nbCheckpointCrossed == checkpointCount;
+	if (result.m_isComplete)
+	{
+		result.m_searchedLapTurns = turn - lastLapFirstTurn;
+		result.m_heuristicTurns = ComputeHeuristicTurns(_checkpoints, &result.m_offsets);
+	}
+	return result;
+}
+
+#pragma endregion
+
+#pragma region Header Output
+
+void WriteHeader(const string& _path, const vector<int>& _mapIndexes, const vector<RacingLineResult>& _results, int _millisecondsPerTurn, int _restarts)
+{
+	ofstream file(_path);
+	file << "#pragma once" << endl << endl;
+	file << "// Generated by Tools/RacingLineOptimizer.cpp with " << _millisecondsPerTurn << "ms per turn, " << _restarts << " restarts per map and "
+		<< OPTIMIZER_BOOST_SIMULATIONS << " simulations per turn of the boost races" << endl << endl;
+	file << "#define KNOWN_MAP_COUNT " << _mapIndexes.size() << endl << endl;
+	file << "constexpr KnownMap KNOWN_MAPS[KNOWN_MAP_COUNT > 0 ? KNOWN_MAP_COUNT : 1] =" << endl << "{" << endl;
+	for (size_t iMap = 0; iMap < _mapIndexes.size(); iMap++)
+	{
+		const vector<RefereePoint> checkpoints = Referee::GetMap(_mapIndexes[iMap]);
+		const RacingLineResult& result = _results[iMap];
+
+		file << "\t{ " << checkpoints.size() << ", {";
+		for (size_t iCheckpoint = 0; iCheckpoint < checkpoints.size(); iCheckpoint++)
+		{
+			file << (iCheckpoint > 0 ? ", " : " ") << "{ " << checkpoints[iCheckpoint].m_x << ", " << checkpoints[iCheckpoint].m_y << " }";
+		}
+		file << " }, {";
+		for (size_t iCheckpoint = 0; iCheckpoint < checkpoints.size(); iCheckpoint++)
+		{
+			const Vector2& offset = result.m_offsets[iCheckpoint];
+			file << (iCheckpoint > 0 ? ", " : " ") << "{ " << (int)round(offset.m_x) << ", " << (int)round(offset.m_y) << " }";
+		}
+		file << " }, {";
+		for (size_t iCheckpoint = 0; iCheckpoint < checkpoints.size(); iCheckpoint++)
+		{
+			file << (iCheckpoint > 0 ? ", " : " ") << result.m_boostCheckpointIndexes[iCheckpoint];
+		}
+		file << " } }," << endl;
+	}
+	file << "};" << endl;
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	const unsigned int threadCount = max(1u, thread::hardware_concurrency());
+	const int millisecondsPerTurn = _argc > 1 ? atoi(_argv[1]) : OPTIMIZER_DEFAULT_MILLISECONDS_PER_TURN;
+	const int restarts = max(_argc > 2 ? atoi(_argv[2]) : OPTIMIZER_DEFAULT_RESTARTS, 1);
+	const string outputPath = _argc > 3 ? _argv[3] : OPTIMIZER_DEFAULT_OUTPUT;
+	const int mapCount = Referee::GetMapCount();
+
+	cout << "Searching the racing lines and boost checkpoints of " << mapCount << " maps, " << restarts << " restarts at " << millisecondsPerTurn << "ms per turn on " << threadCount << " threads" << endl;
+
+	// Every restart of every map is a job, the best restart of each map is kept
+	vector<RacingLineResult> results(mapCount * restarts);
+	atomic<int> nextJob(0);
+	auto worker = [&]()
+	{
+		for (int iJob = nextJob++; iJob < (int)results.size(); iJob = nextJob++)
+		{
+			results[iJob] = SearchRacingLine(Referee::GetMap(iJob / restarts), millisecondsPerTurn, 1000u + (unsigned int)iJob * 7919u);
+		}
+	};
+	vector<thread> threads;
+	for (unsigned int iThread = 0; iThread < threadCount; iThread++) threads.emplace_back(worker);
+	for (thread& workerThread : threads) workerThread.join();
+
+	// A racing line is only kept when it makes the heuristic faster than aiming at the centers, where the offsets stay null
+	vector<int> mapIndexes;
+	vector<RacingLineResult> bestResults;
+	for (int iMap = 0; iMap < mapCount; iMap++)
+	{
+		const vector<RefereePoint> checkpoints = Referee::GetMap(iMap);
+		const int centerTurns = ComputeHeuristicTurns(checkpoints, nullptr);
+
+		const RacingLineResult* bestResult = nullptr;
+		for (int iRestart = 0; iRestart < restarts; iRestart++)
+		{
+			const RacingLineResult& result = results[iMap * restarts + iRestart];
+			if (false == result.m_isComplete) continue;
+			if (bestResult == nullptr || result.m_heuristicTurns < bestResult->m_heuristicTurns) bestResult = &result;
+		}
+
+		cout << "Map " << iMap << " : heuristic laps in " << centerTurns << " turns aiming at the centers";
+		if (bestResult != nullptr) cout << ", " << bestResult->m_heuristicTurns << " following the racing line, searched lap in " << bestResult->m_searchedLapTurns << " turns";
+		cout << endl;
+
+		mapIndexes.push_back(iMap);
+		if (bestResult != nullptr && bestResult->m_heuristicTurns < centerTurns) bestResults.push_back(*bestResult);
+		else
+		{
+			bestResults.push_back(RacingLineResult());
+			bestResults.back().m_offsets.fill(Vector2::Zero);
+		}
+	}
+
+	// Then every starting checkpoint of every map is a job, racing along the kept line
+	vector<pair<int, int>> boostJobs;
+	for (int iMap = 0; iMap < mapCount; iMap++)
+	{
+		for (int iStart = 0; iStart < (int)Referee::GetMap(iMap).size(); iStart++) boostJobs.push_back({ iMap, iStart });
+	}
+	nextJob = 0;
+	auto boostWorker = [&]()
+	{
+		for (int iJob = nextJob++; iJob < (int)boostJobs.size(); iJob = nextJob++)
+		{
+			RacingLineResult& result = bestResults[boostJobs[iJob].first];
+			result.m_boostCheckpointIndexes[boostJobs[iJob].second] = SearchBoostCheckpoint(Referee::GetMap(boostJobs[iJob].first), result.m_offsets, boostJobs[iJob].second);
+		}
+	};
+	threads.clear();
+	for (unsigned int iThread = 0; iThread < threadCount; iThread++) threads.emplace_back(boostWorker);
+	for (thread& workerThread : threads) workerThread.join();
+
+	WriteHeader(outputPath, mapIndexes, bestResults, millisecondsPerTurn, restarts);
+	cout << mapIndexes.size() << " maps written to " << outputPath << endl;
+}
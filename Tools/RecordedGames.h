@@ -0,0 +1,221 @@
+#pragma once
+
+// Self-play games recorded frame by frame, with the text format shared by the tools that replay them.
+// Arena games can be imported from the transcript of a replay, the only frames that come from the real referee.
+// Include it after Gold.cpp, Referee.h and GoldPlayer.h.
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+
+#pragma region Recorded Frames
+
+struct RecordedFrame
+{
+	array<RefereePod, REFEREE_POD_TOTAL_NB> m_podsBefore;
+	array<RefereeCommand, REFEREE_POD_TOTAL_NB> m_commands; // Pods 0 and 1 from player 0, 2 and 3 from player 1
+	array<RefereePod, REFEREE_POD_TOTAL_NB> m_podsAfter;
+};
+
+struct RecordedGame
+{
+	vector<RefereePoint> m_checkpoints;
+	int m_numberOfLaps = 0;
+	vector<RecordedFrame> m_frames;
+};
+
+inline RecordedGame RecordGame(int _mapIndex, unsigned int _seed, const SearchParameters& _parameters)
+{
+	Random::SetSeed(_seed);
+
+	Referee referee;
+	referee.Initialize(_mapIndex, _seed);
+
+	RecordedGame game;
+	game.m_checkpoints = referee.GetCheckpoints();
+	game.m_numberOfLaps = referee.GetNumberOfLaps();
+
+	array<unique_ptr<GoldPlayer>, REFEREE_PLAYER_NB> players;
+	for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+	{
+		players[iPlayer] = make_unique<GoldPlayer>(_parameters);
+		players[iPlayer]->Initialize(referee);
+	}
+
+	while (false == referee.IsOver())
+	{
+		RecordedFrame frame;
+		frame.m_podsBefore = referee.GetPods();
+		array<RefereeCommand, REFEREE_POD_PER_PLAYER> commandsPlayer0 = players[0]->PlayTurn(referee.GetPodsInputs(0));
+		array<RefereeCommand, REFEREE_POD_PER_PLAYER> commandsPlayer1 = players[1]->PlayTurn(referee.GetPodsInputs(1));
+		for (int iPod = 0; iPod < REFEREE_POD_PER_PLAYER; iPod++)
+		{
+			frame.m_commands[iPod] = commandsPlayer0[iPod];
+			frame.m_commands[iPod + REFEREE_POD_PER_PLAYER] = commandsPlayer1[iPod];
+		}
+		referee.PlayTurn(commandsPlayer0, commandsPlayer1);
+		frame.m_podsAfter = referee.GetPods();
+		game.m_frames.push_back(frame);
+	}
+	return game;
+}
+
+inline void WritePod(ostream& _stream, const RefereePod& _pod)
+{
+	_stream << " " << _pod.m_x << " " << _pod.m_y << " " << _pod.m_speedX << " " << _pod.m_speedY << " " << _pod.m_angle << " " << _pod.m_mass
+		<< " " << _pod.m_nextCheckpointIndex << " " << _pod.m_checkpointPassedCount << " " << _pod.m_shieldCooldown << " " << _pod.m_usedBoost;
+}
+
+inline void ReadPod(istream& _stream, RefereePod& _pod)
+{
+	_stream >> _pod.m_x >> _pod.m_y >> _pod.m_speedX >> _pod.m_speedY >> _pod.m_angle >> _pod.m_mass
+		>> _pod.m_nextCheckpointIndex >> _pod.m_checkpointPassedCount >> _pod.m_shieldCooldown >> _pod.m_usedBoost;
+}
+
+// One game per block : laps, checkpoints, frame count, then one line per frame
+inline void WriteGames(const string& _path, const vector<RecordedGame>& _games)
+{
+	ofstream file(_path);
+	file << setprecision(17) << _games.size() << endl;
+	for (const RecordedGame& game : _games)
+	{
+		file << game.m_numberOfLaps << " " << game.m_checkpoints.size();
+		for (const RefereePoint& checkpoint : game.m_checkpoints) file << " " << checkpoint.m_x << " " << checkpoint.m_y;
+		file << endl << game.m_frames.size() << endl;
+
+		for (const RecordedFrame& frame : game.m_frames)
+		{
+			for (const RefereePod& pod : frame.m_podsBefore) WritePod(file, pod);
+			for (const RefereeCommand& command : frame.m_commands)
+			{
+				file << " " << command.m_targetX << " " << command.m_targetY << " " << command.m_thrust << " " << command.m_useBoost << " " << command.m_useShield;
+			}
+			for (const RefereePod& pod : frame.m_podsAfter) WritePod(file, pod);
+			file << endl;
+		}
+	}
+}
+
+inline vector<RecordedGame> ReadGames(const string& _path)
+{
+	ifstream file(_path);
+	size_t gameCount = 0;
+	file >> gameCount;
+
+	vector<RecordedGame> games(gameCount);
+	for (RecordedGame& game : games)
+	{
+		size_t checkpointCount = 0;
+		file >> game.m_numberOfLaps >> checkpointCount;
+		game.m_checkpoints.resize(checkpointCount);
+		for (RefereePoint& checkpoint : game.m_checkpoints) file >> checkpoint.m_x >> checkpoint.m_y;
+
+		size_t frameCount = 0;
+		file >> frameCount;
+		game.m_frames.resize(frameCount);
+		for (RecordedFrame& frame : game.m_frames)
+		{
+			for (RefereePod& pod : frame.m_podsBefore) ReadPod(file, pod);
+			for (RefereeCommand& command : frame.m_commands)
+			{
+				file >> command.m_targetX >> command.m_targetY >> command.m_thrust >> command.m_useBoost >> command.m_useShield;
+			}
+			for (RefereePod& pod : frame.m_podsAfter) ReadPod(file, pod);
+		}
+	}
+	return games;
+}
+
+// The arena command syntax, the debug message after the thrust is ignored
+inline RefereeCommand ParseArenaCommand(const string& _line)
+{
+	RefereeCommand command;
+	istringstream stream(_line);
+	string thrust;
+	stream >> command.m_targetX >> command.m_targetY >> thrust;
+	if (thrust == "BOOST") command.m_useBoost = true;
+	else if (thrust == "SHIELD") command.m_useShield = true;
+	else command.m_thrust = atoi(thrust.c_str());
+	return command;
+}
+
+// Transcript of an arena replay : the map input of the first player, then every turn its four pod lines
+// followed by the two output lines of each player. The state the inputs do not show is rebuilt from the commands :
+// checkpoints passed, boost, shield cooldown. The inputs round the angle, the only field known less precisely than the referee.
+inline RecordedGame ImportArenaGame(istream& _stream)
+{
+	RecordedGame game;
+	int checkpointCount = 0;
+	_stream >> game.m_numberOfLaps >> checkpointCount;
+	game.m_checkpoints.resize(max(checkpointCount, 0));
+	for (RefereePoint& checkpoint : game.m_checkpoints) _stream >> checkpoint.m_x >> checkpoint.m_y;
+
+	array<RefereePod, REFEREE_POD_TOTAL_NB> pods; // After the commands of the last turn read, for the fields the inputs do not show
+	array<RefereePod, REFEREE_POD_TOTAL_NB> previousPods; // Before the commands of the last turn read
+	array<RefereeCommand, REFEREE_POD_TOTAL_NB> commands;
+	bool hasPreviousTurn = false;
+	while (true)
+	{
+		array<RefereePod, REFEREE_POD_TOTAL_NB> turnPods = pods;
+		bool isTurnRead = true;
+		for (RefereePod& pod : turnPods)
+		{
+			RefereePodInput input;
+			isTurnRead = isTurnRead && (bool)(_stream >> input.m_x >> input.m_y >> input.m_speedX >> input.m_speedY >> input.m_angle >> input.m_nextCheckpointIndex);
+			pod.m_x = input.m_x;
+			pod.m_y = input.m_y;
+			pod.m_speedX = input.m_speedX;
+			pod.m_speedY = input.m_speedY;
+			pod.m_angle = input.m_angle < 0 ? -1.0 : input.m_angle;
+			pod.m_mass = 1.0;
+			if (hasPreviousTurn && input.m_nextCheckpointIndex != pod.m_nextCheckpointIndex) pod.m_checkpointPassedCount++;
+			pod.m_nextCheckpointIndex = input.m_nextCheckpointIndex;
+		}
+		if (false == isTurnRead) break;
+
+		if (hasPreviousTurn)
+		{
+			RecordedFrame frame;
+			frame.m_podsBefore = previousPods;
+			frame.m_commands = commands;
+			frame.m_podsAfter = turnPods;
+			game.m_frames.push_back(frame);
+		}
+
+		string line;
+		getline(_stream, line); // End of the last pod line
+		for (RefereeCommand& command : commands)
+		{
+			if (false == (bool)getline(_stream, line)) return game;
+			command = ParseArenaCommand(line);
+		}
+
+		// The boost and the shield of this turn belong to the state before the next one
+		previousPods = turnPods;
+		pods = turnPods;
+		for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+		{
+			RefereePod commandedPod = pods[iPod];
+			Referee::ApplyCommand(commandedPod, commands[iPod]);
+			pods[iPod].m_shieldCooldown = commandedPod.m_shieldCooldown;
+			pods[iPod].m_usedBoost = commandedPod.m_usedBoost;
+		}
+		hasPreviousTurn = true;
+	}
+	return game;
+}
+
+inline PodInput CreatePodInput(const RefereePod& _pod)
+{
+	// Same truncation as the inputs the referee sends
+	PodInput input;
+	input.m_x = (int)_pod.m_x;
+	input.m_y = (int)_pod.m_y;
+	input.m_speedX = (int)_pod.m_speedX;
+	input.m_speedY = (int)_pod.m_speedY;
+	input.m_angle = (int)_pod.m_angle;
+	input.m_nextCheckpointIndex = _pod.m_nextCheckpointIndex;
+	return input;
+}
+
+#pragma endregion
@@ -0,0 +1,336 @@
+#include "Referee.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+#define REFEREE_PI 3.14159265358979323846
+#define REFEREE_MAX_EVENTS_PER_TURN 32
+
+#pragma region Map Pool
+
+// Checkpoint layouts of the arena map pool
+static const vector<vector<RefereePoint>> s_maps =
+{
+	{ { 12460, 1350 }, { 10540, 5980 }, { 3580, 5180 }, { 13580, 7600 } },
+	{ { 3600, 5280 }, { 13840, 5080 }, { 10680, 2280 }, { 8700, 7460 }, { 7200, 2160 } },
+	{ { 4560, 2180 }, { 7350, 4940 }, { 3320, 7230 }, { 14580, 7700 }, { 10560, 5060 }, { 13100, 2320 } },
+	{ { 5010, 5260 }, { 11480, 6080 }, { 9100, 1840 } },
+	{ { 14660, 1410 }, { 3450, 7220 }, { 9420, 7240 }, { 5970, 4240 } },
+	{ { 3640, 4420 }, { 8000, 7900 }, { 13300, 5540 }, { 9560, 1400 } },
+	{ { 4100, 7420 }, { 13500, 2340 }, { 12940, 7220 }, { 5640, 2580 } },
+	{ { 14520, 7780 }, { 6320, 4290 }, { 7800, 860 }, { 7660, 5970 }, { 3140, 7540 }, { 9520, 4380 } },
+	{ { 10040, 5970 }, { 13920, 1940 }, { 8020, 3260 }, { 2670, 7020 } },
+	{ { 7500, 6940 }, { 6000, 5360 }, { 11300, 2820 } },
+	{ { 4060, 4660 }, { 13040, 1900 }, { 6560, 7840 }, { 7480, 1360 }, { 12700, 7100 } },
+	{ { 3020, 5190 }, { 6280, 7760 }, { 14100, 7760 }, { 13880, 1220 }, { 10240, 4920 }, { 6100, 2200 } },
+	{ { 10323, 3366 }, { 11203, 5425 }, { 7259, 6656 }, { 5425, 2838 } },
+};
+
+int Referee::GetMapCount()
+{
+	return (int)s_maps.size();
+}
+
+vector<RefereePoint> Referee::GetMap(int _mapIndex)
+{
+	return s_maps[_mapIndex % s_maps.size()];
+}
+
+#pragma endregion
+
+#pragma region Game Setup
+
+void Referee::Initialize(int _mapIndex, unsigned int _seed, int _numberOfLaps)
+{
+	// Like the arena, start from a random checkpoint of the layout and move every checkpoint a little
+	mt19937 generator(_seed);
+	vector<RefereePoint> layout = GetMap(_mapIndex);
+	uniform_int_distribution<int> jitter(-REFEREE_CHECKPOINT_JITTER, REFEREE_CHECKPOINT_JITTER);
+	rotate(layout.begin(), layout.begin() + (generator() % layout.size()), layout.end());
+	for (RefereePoint& checkpoint : layout)
+	{
+		checkpoint.m_x += jitter(generator);
+		checkpoint.m_y += jitter(generator);
+	}
+	Initialize(layout, _numberOfLaps);
+}
+
+void Referee::Initialize(const vector<RefereePoint>& _checkpoints, int _numberOfLaps)
+{
+	m_checkpoints = _checkpoints;
+	m_numberOfLaps = _numberOfLaps;
+	m_turn = 0;
+	m_winner = -1;
+	m_turnsWithoutCheckpoint = {};
+
+	// Pods are lined up on the first checkpoint, perpendicular to the first leg, alternating between players
+	const RefereePoint& start = m_checkpoints[0];
+	const RefereePoint& next = m_checkpoints[1];
+	double legX = next.m_x - start.m_x;
+	double legY = next.m_y - start.m_y;
+	double legLength = sqrt(legX * legX + legY * legY);
+	double normalX = -legY / legLength;
+	double normalY = legX / legLength;
+
+	const double offsets[REFEREE_POD_TOTAL_NB] = { 500.0, 1500.0, -500.0, -1500.0 };
+	for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+	{
+		RefereePod& pod = m_pods[iPod];
+		pod = RefereePod();
+		pod.m_x = round(start.m_x + normalX * offsets[iPod]);
+		pod.m_y = round(start.m_y + normalY * offsets[iPod]);
+	}
+}
+
+#pragma endregion
+
+#pragma region Turn
+
+array<RefereePodInput, REFEREE_POD_TOTAL_NB> Referee::GetPodsInputs(int _player) const
+{
+	array<RefereePodInput, REFEREE_POD_TOTAL_NB> inputs;
+	for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+	{
+		// The player always reads its own pods first
+		const RefereePod& pod = m_pods[(iPod + _player * REFEREE_POD_PER_PLAYER) % REFEREE_POD_TOTAL_NB];
+		RefereePodInput& input = inputs[iPod];
+		input.m_x = (int)pod.m_x;
+		input.m_y = (int)pod.m_y;
+		input.m_speedX = (int)pod.m_speedX;
+		input.m_speedY = (int)pod.m_speedY;
+		input.m_angle = (int)pod.m_angle;
+		input.m_nextCheckpointIndex = pod.m_nextCheckpointIndex;
+	}
+	return inputs;
+}
+
+void Referee::PlayTurn(const array<RefereeCommand, REFEREE_POD_PER_PLAYER>& _commandsPlayer0, const array<RefereeCommand, REFEREE_POD_PER_PLAYER>& _commandsPlayer1)
+{
+	if (IsOver()) return;
+
+	for (int iPod = 0; iPod < REFEREE_POD_PER_PLAYER; iPod++)
+	{
+		ApplyCommand(m_pods[iPod], _commandsPlayer0[iPod]);
+		ApplyCommand(m_pods[iPod + REFEREE_POD_PER_PLAYER], _commandsPlayer1[iPod]);
+	}
+
+	array<int, REFEREE_POD_TOTAL_NB> passedBefore;
+	for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++) passedBefore[iPod] = m_pods[iPod].m_checkpointPassedCount;
+
+	MovePods();
+	EndTurn();
+
+	m_turn++;
+	const int checkpointCountRace = (int)m_checkpoints.size() * m_numberOfLaps;
+	for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+	{
+		bool hasPassedCheckpoint = false;
+		for (int iPod = 0; iPod < REFEREE_POD_PER_PLAYER; iPod++)
+		{
+			const int podIndex = iPlayer * REFEREE_POD_PER_PLAYER + iPod;
+			if (m_pods[podIndex].m_checkpointPassedCount != passedBefore[podIndex]) hasPassedCheckpoint = true;
+			if (m_pods[podIndex].m_checkpointPassedCount >= checkpointCountRace && m_winner < 0) m_winner = iPlayer;
+		}
+		m_turnsWithoutCheckpoint[iPlayer] = hasPassedCheckpoint ? 0 : m_turnsWithoutCheckpoint[iPlayer] + 1;
+	}
+	if (m_winner >= 0) return;
+
+	// A player that did not pass any checkpoint for too long loses the race
+	for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+	{
+		if (m_turnsWithoutCheckpoint[iPlayer] >= REFEREE_TIMEOUT_TURNS) m_winner = 1 - iPlayer;
+	}
+}
+
+void Referee::ApplyCommand(RefereePod& _pod, const RefereeCommand& _command)
+{
+	// Rotation toward the target, limited after the first turn
+	double targetX = _command.m_targetX - _pod.m_x;
+	double targetY = _command.m_targetY - _pod.m_y;
+	if (targetX != 0.0 || targetY != 0.0)
+	{
+		double targetAngle = atan2(targetY, targetX) * 180.0 / REFEREE_PI;
+		if (targetAngle < 0.0) targetAngle += 360.0;
+
+		if (_pod.m_angle < 0.0)
+		{
+			_pod.m_angle = targetAngle;
+		}
+		else
+		{
+			double difference = targetAngle - _pod.m_angle;
+			if (difference > 180.0) difference -= 360.0;
+			if (difference < -180.0) difference += 360.0;
+			difference = clamp(difference, -REFEREE_MAXIMUM_ROTATION, REFEREE_MAXIMUM_ROTATION);
+			_pod.m_angle = fmod(_pod.m_angle + difference + 360.0, 360.0);
+		}
+	}
+	if (_pod.m_angle < 0.0) _pod.m_angle = 0.0;
+
+	// Shield makes the pod heavy and prevents any acceleration for a few turns
+	_pod.m_mass = 1.0;
+	if (_command.m_useShield)
+	{
+		_pod.m_shieldCooldown = REFEREE_SHIELD_COOLDOWN + 1;
+	}
+	if (_pod.m_shieldCooldown > 0)
+	{
+		if (_pod.m_shieldCooldown == REFEREE_SHIELD_COOLDOWN + 1) _pod.m_mass = REFEREE_SHIELD_MASS;
+		_pod.m_shieldCooldown--;
+		return;
+	}
+
+	int thrust = clamp(_command.m_thrust, 0, 100);
+	if (_command.m_useBoost)
+	{
+		thrust = _pod.m_usedBoost ? 100 : REFEREE_BOOST_ACCELERATION;
+		_pod.m_usedBoost = true;
+	}
+
+	double angleRad = _pod.m_angle * REFEREE_PI / 180.0;
+	_pod.m_speedX += cos(angleRad) * thrust;
+	_pod.m_speedY += sin(angleRad) * thrust;
+}
+
+void Referee::MovePods()
+{
+	double time = 0.0;
+	int lastPod1 = -1;
+	int lastPod2 = -1;
+	int eventCount = 0;
+	while (time < 1.0)
+	{
+		// Pods stuck against each other could bounce forever without moving the time forward
+		bool canCollide = ++eventCount <= REFEREE_MAX_EVENTS_PER_TURN;
+
+		// Find the first event of the remaining time: a collision between pods or a checkpoint crossing
+		double firstTime = 1.0 - time;
+		int firstPod1 = -1;
+		int firstPod2 = -1;
+		for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+		{
+			for (int iOtherPod = iPod + 1; iOtherPod < REFEREE_POD_TOTAL_NB; iOtherPod++)
+			{
+				if (false == canCollide || (iPod == lastPod1 && iOtherPod == lastPod2)) continue;
+				double collisionTime = FindCollisionTime(m_pods[iPod], m_pods[iOtherPod]);
+				if (collisionTime >= 0.0 && collisionTime < firstTime)
+				{
+					firstTime = collisionTime;
+					firstPod1 = iPod;
+					firstPod2 = iOtherPod;
+				}
+			}
+		}
+
+		for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+		{
+			RefereePod& pod = m_pods[iPod];
+			double checkpointTime = FindCheckpointTime(pod);
+			if (checkpointTime >= 0.0 && checkpointTime <= firstTime)
+			{
+				pod.m_checkpointPassedCount++;
+				pod.m_nextCheckpointIndex = (pod.m_nextCheckpointIndex + 1) % (int)m_checkpoints.size();
+			}
+		}
+
+		for (RefereePod& pod : m_pods)
+		{
+			pod.m_x += pod.m_speedX * firstTime;
+			pod.m_y += pod.m_speedY * firstTime;
+		}
+		time += firstTime;
+
+		lastPod1 = firstPod1;
+		lastPod2 = firstPod2;
+		if (firstPod1 >= 0) Bounce(m_pods[firstPod1], m_pods[firstPod2]);
+	}
+}
+
+void Referee::EndTurn()
+{
+	for (RefereePod& pod : m_pods)
+	{
+		pod.m_x = round(pod.m_x);
+		pod.m_y = round(pod.m_y);
+		pod.m_speedX = trunc(pod.m_speedX * REFEREE_FRICTION);
+		pod.m_speedY = trunc(pod.m_speedY * REFEREE_FRICTION);
+		pod.m_angle = round(pod.m_angle);
+		if (pod.m_angle >= 360.0) pod.m_angle -= 360.0;
+	}
+}
+
+void Referee::Bounce(RefereePod& _pod1, RefereePod& _pod2)
+{
+	double normalX = _pod2.m_x - _pod1.m_x;
+	double normalY = _pod2.m_y - _pod1.m_y;
+	double squareDistance = normalX * normalX + normalY * normalY;
+	if (squareDistance <= 0.0) return;
+
+	double massCoefficient = (_pod1.m_mass + _pod2.m_mass) / (_pod1.m_mass * _pod2.m_mass);
+	double relativeSpeedX = _pod2.m_speedX - _pod1.m_speedX;
+	double relativeSpeedY = _pod2.m_speedY - _pod1.m_speedY;
+	double product = normalX * relativeSpeedX + normalY * relativeSpeedY;
+
+	double forceX = (normalX * product) / (squareDistance * massCoefficient);
+	double forceY = (normalY * product) / (squareDistance * massCoefficient);
+
+	_pod1.m_speedX += forceX / _pod1.m_mass;
+	_pod1.m_speedY += forceY / _pod1.m_mass;
+	_pod2.m_speedX -= forceX / _pod2.m_mass;
+	_pod2.m_speedY -= forceY / _pod2.m_mass;
+
+	// The second half of the impulse is never below the minimum impulse
+	double impulse = sqrt(forceX * forceX + forceY * forceY);
+	if (impulse > 0.0 && impulse < REFEREE_MINIMUM_IMPULSE)
+	{
+		forceX *= REFEREE_MINIMUM_IMPULSE / impulse;
+		forceY *= REFEREE_MINIMUM_IMPULSE / impulse;
+	}
+
+	_pod1.m_speedX += forceX / _pod1.m_mass;
+	_pod1.m_speedY += forceY / _pod1.m_mass;
+	_pod2.m_speedX -= forceX / _pod2.m_mass;
+	_pod2.m_speedY -= forceY / _pod2.m_mass;
+}
+
+double Referee::FindCollisionTime(const RefereePod& _pod1, const RefereePod& _pod2) const
+{
+	// Solve |relativePosition + relativeSpeed * t| = radius for the smallest positive t
+	double positionX = _pod2.m_x - _pod1.m_x;
+	double positionY = _pod2.m_y - _pod1.m_y;
+	double speedX = _pod2.m_speedX - _pod1.m_speedX;
+	double speedY = _pod2.m_speedY - _pod1.m_speedY;
+	double radius = REFEREE_POD_RADIUS * 2.0;
+
+	double a = speedX * speedX + speedY * speedY;
+	if (a <= 0.0) return -1.0;
+	double b = 2.0 * (positionX * speedX + positionY * speedY);
+	double c = positionX * positionX + positionY * positionY - radius * radius;
+	if (b >= 0.0) return -1.0; // Pods are moving away from each other
+	if (c <= 0.0) return 0.0; // Already touching
+	double delta = b * b - 4.0 * a * c;
+	if (delta < 0.0) return -1.0;
+	return (-b - sqrt(delta)) / (2.0 * a);
+}
+
+double Referee::FindCheckpointTime(const RefereePod& _pod) const
+{
+	const RefereePoint& checkpoint = m_checkpoints[_pod.m_nextCheckpointIndex];
+	double positionX = _pod.m_x - checkpoint.m_x;
+	double positionY = _pod.m_y - checkpoint.m_y;
+	double radius = REFEREE_CHECKPOINT_RADIUS;
+
+	double c = positionX * positionX + positionY * positionY - radius * radius;
+	if (c <= 0.0) return 0.0;
+	double a = _pod.m_speedX * _pod.m_speedX + _pod.m_speedY * _pod.m_speedY;
+	if (a <= 0.0) return -1.0;
+	double b = 2.0 * (positionX * _pod.m_speedX + positionY * _pod.m_speedY);
+	double delta = b * b - 4.0 * a * c;
+	if (delta < 0.0) return -1.0;
+	double time = (-b - sqrt(delta)) / (2.0 * a);
+	return time >= 0.0 ? time : -1.0;
+}
+
+#pragma endregion
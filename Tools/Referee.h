@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+// Local re-implementation of the Coders Strike Back referee, used by the tools to play games in-process.
+// Ressources : http://files.magusgeek.com/csb/csb.html
+
+#define REFEREE_POD_TOTAL_NB 4
+#define REFEREE_POD_PER_PLAYER 2
+#define REFEREE_PLAYER_NB 2
+
+#define REFEREE_POD_RADIUS 400.0
+#define REFEREE_CHECKPOINT_RADIUS 600.0
+#define REFEREE_MAXIMUM_ROTATION 18.0
+#define REFEREE_FRICTION 0.85
+#define REFEREE_BOOST_ACCELERATION 650
+#define REFEREE_MINIMUM_IMPULSE 120.0
+#define REFEREE_SHIELD_MASS 10.0
+#define REFEREE_SHIELD_COOLDOWN 3
+#define REFEREE_TIMEOUT_TURNS 100
+#define REFEREE_MAX_TURNS 600
+#define REFEREE_DEFAULT_LAPS 3
+#define REFEREE_CHECKPOINT_JITTER 30
+
+#pragma region Referee Structures
+
+struct RefereePoint
+{
+	int m_x = 0;
+	int m_y = 0;
+};
+
+// What a bot reads for one pod each turn, already in the point of view of the player
+struct RefereePodInput
+{
+	int m_x = 0;
+	int m_y = 0;
+	int m_speedX = 0;
+	int m_speedY = 0;
+	int m_angle = 0;
+	int m_nextCheckpointIndex = 0;
+};
+
+// What a bot writes for one pod each turn
+struct RefereeCommand
+{
+	int m_targetX = 0;
+	int m_targetY = 0;
+	int m_thrust = 0;
+	bool m_useBoost = false;
+	bool m_useShield = false;
+};
+
+struct RefereePod
+{
+	double m_x = 0.0;
+	double m_y = 0.0;
+	double m_speedX = 0.0;
+	double m_speedY = 0.0;
+	double m_angle = -1.0; // Negative until the first rotation, the pod can face any direction on the first turn
+	double m_mass = 1.0;
+	int m_nextCheckpointIndex = 1;
+	int m_checkpointPassedCount = 0;
+	int m_shieldCooldown = 0;
+	bool m_usedBoost = false;
+};
+
+#pragma endregion
+
+#pragma region Referee Class
+
+class Referee
+{
+public:
+
+	static int GetMapCount();
+	static std::vector<RefereePoint> GetMap(int _mapIndex);
+
+	void Initialize(int _mapIndex, unsigned int _seed, int _numberOfLaps = REFEREE_DEFAULT_LAPS);
+	void Initialize(const std::vector<RefereePoint>& _checkpoints, int _numberOfLaps = REFEREE_DEFAULT_LAPS);
+
+	std::array<RefereePodInput, REFEREE_POD_TOTAL_NB> GetPodsInputs(int _player) const;
+	void PlayTurn(const std::array<RefereeCommand, REFEREE_POD_PER_PLAYER>& _commandsPlayer0, const std::array<RefereeCommand, REFEREE_POD_PER_PLAYER>& _commandsPlayer1);
+
+	bool IsOver() const { return m_winner >= 0 || m_turn >= REFEREE_MAX_TURNS; }
+	int GetWinner() const { return m_winner; } // -1 while running or on a draw
+	int GetTurn() const { return m_turn; }
+	int GetNumberOfLaps() const { return m_numberOfLaps; }
+	const std::vector<RefereePoint>& GetCheckpoints() const { return m_checkpoints; }
+	const std::array<RefereePod, REFEREE_POD_TOTAL_NB>& GetPods() const { return m_pods; }
+
+	// Rotation, shield and thrust of one pod, before the pods move. Public so the tools can reproduce a turn step by step.
+	static void ApplyCommand(RefereePod& _pod, const RefereeCommand& _command);
+
+private:
+
+	void MovePods();
+	void EndTurn();
+	void Bounce(RefereePod& _pod1, RefereePod& _pod2);
+	double FindCollisionTime(const RefereePod& _pod1, const RefereePod& _pod2) const;
+	double FindCheckpointTime(const RefereePod& _pod) const;
+
+	std::vector<RefereePoint> m_checkpoints;
+	std::array<RefereePod, REFEREE_POD_TOTAL_NB> m_pods; // Pods 0 and 1 belong to player 0, pods 2 and 3 to player 1
+	std::array<int, REFEREE_PLAYER_NB> m_turnsWithoutCheckpoint = {};
+	int m_numberOfLaps = REFEREE_DEFAULT_LAPS;
+	int m_turn = 0;
+	int m_winner = -1;
+};
+
+#pragma endregion
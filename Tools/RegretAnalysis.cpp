@@ -0,0 +1,274 @@
+// Re-solves every recorded turn of Gold.cpp games with a much larger budget and measures the regret of the racer moves played.
+// Build : g++ -std=c++17 -O2 -pthread Tools/RegretAnalysis.cpp Tools/Referee.cpp -o RegretAnalysis
+// Usage : RegretAnalysis framesFile [referenceMilliseconds] [turnStride]
+// The frames file is written by PhysicsFidelity, only one turn out of the stride is analysed.
+// The regret of a turn is the score the long search reaches after its own move, minus the one it reaches after the move played.
+
+#define GOLD_NO_MAIN
+#define GOLD_SILENT
+#include "../Gold.cpp"
+
+#include "Referee.h"
+#include "GoldPlayer.h"
+#include "RecordedGames.h"
+
+#include <atomic>
+#include <thread>
+
+#define REGRET_DEFAULT_REFERENCE_MILLISECONDS (TIME_ALLOCATED_PER_TURN * 10)
+#define REGRET_DEFAULT_TURN_STRIDE 1
+#define REGRET_SEED 4242u
+
+// A played move agreeing with the reference one has no regret, and is not searched again
+#define REGRET_ROTATION_TOLERANCE 3
+#define REGRET_THRUST_TOLERANCE 15
+
+#pragma region Situations
+
+// A turn belongs to every situation that applies, the others go to SITUATION_OTHER
+enum Situation
+{
+	SITUATION_FIRST_TURN,
+	SITUATION_CHECKPOINT_APPROACH,
+	SITUATION_COLLISION,
+	SITUATION_FINAL_LAP,
+	SITUATION_OTHER,
+	SITUATION_COUNT,
+};
+
+const char* SITUATION_NAMES[SITUATION_COUNT] = { "first turn", "checkpoint approach", "collision", "final lap", "other" };
+
+#pragma endregion
+
+#pragma region Recorded Positions
+
+// A turn as the bot of one player saw it, with the moves it sent
+struct RegretPosition
+{
+	Simulation m_simulation;
+	Move m_playedMove; // Racer
+	Move m_partnerMove; // Blocker, repeated over the whole horizon by every search
+	array<Pod, POD_TOTAL_NB - POD_CONTROLLABLE_NB> m_commandedOpponents; // After the rotation and thrust of the referee
+	array<bool, SITUATION_COUNT> m_situations = {};
+};
+
+Move CreateMove(const RefereePod& _pod, const RefereeCommand& _command)
+{
+	RefereePod commandedPod = _pod;
+	Referee::ApplyCommand(commandedPod, _command);
+
+	Move move;
+	int rotation = (int)round(fmod(round(commandedPod.m_angle) - (int)_pod.m_angle + 540.0, 360.0) - 180.0);
+	move.m_rotation = clamp(rotation, (int)-POD_MAXIMUM_ROTATION, (int)POD_MAXIMUM_ROTATION);
+	move.m_thrust = clamp(_command.m_thrust, 0, POD_MAX_THRUST);
+	move.m_useBoost = _command.m_useBoost;
+	move.m_useShield = _command.m_useShield;
+	return move;
+}
+
+// The racer plays the given move, the blocker its recorded one and the opponents the commands the referee applied
+void PlayFirstTurn(const RegretPosition& _position, const Move& _move, Simulation* _simulation)
+{
+	*_simulation = _position.m_simulation;
+	_simulation->m_tempPods = _simulation->m_pods;
+	for (int iPod = POD_CONTROLLABLE_NB; iPod < POD_TOTAL_NB; iPod++) _simulation->m_tempPods[iPod] = _position.m_commandedOpponents[iPod - POD_CONTROLLABLE_NB];
+
+	array<Move, POD_NB_TO_SIMULATE> moves;
+	moves[RACER_POD_INDEX] = _move;
+	moves[BLOCKER_POD_INDEX] = _position.m_partnerMove;
+	const bool useOpponentModels = _simulation->m_useOpponentModels;
+	_simulation->m_useOpponentModels = false;
+	_simulation->SimulateTurn(moves);
+	_simulation->m_useOpponentModels = useOpponentModels;
+
+	_simulation->m_pods = _simulation->m_tempPods;
+	_simulation->m_turn++;
+}
+
+// Every player of every game is followed from the first turn, so the opponent models are the ones the bot had
+void CreatePositions(const RecordedGame& _game, int _turnStride, vector<RegretPosition>* _positions)
+{
+	vector<Vector2> checkpointPositions;
+	for (const RefereePoint& checkpoint : _game.m_checkpoints) checkpointPositions.push_back(Vector2((float)checkpoint.m_x, (float)checkpoint.m_y));
+
+	for (int iPlayer = 0; iPlayer < REFEREE_PLAYER_NB; iPlayer++)
+	{
+		Simulation simulation;
+		simulation.InitializeCheckpoints(_game.m_numberOfLaps, checkpointPositions);
+
+		for (int iFrame = 0; iFrame < (int)_game.m_frames.size(); iFrame++)
+		{
+			const RecordedFrame& frame = _game.m_frames[iFrame];
+			array<RefereePod, REFEREE_POD_TOTAL_NB> pods;
+			array<RefereeCommand, REFEREE_POD_TOTAL_NB> commands;
+			array<PodInput, POD_TOTAL_NB> inputs;
+			for (int iPod = 0; iPod < REFEREE_POD_TOTAL_NB; iPod++)
+			{
+				const int recordedIndex = (iPod + iPlayer * REFEREE_POD_PER_PLAYER) % REFEREE_POD_TOTAL_NB;
+				pods[iPod] = frame.m_podsBefore[recordedIndex];
+				commands[iPod] = frame.m_commands[recordedIndex];
+				inputs[iPod] = CreatePodInput(pods[iPod]);
+			}
+			simulation.ApplyPodsInputs(inputs, iFrame == 0);
+			if (iFrame % _turnStride != 0) continue;
+
+			RegretPosition position;
+			position.m_simulation = simulation;
+			position.m_playedMove = CreateMove(pods[RACER_POD_INDEX], commands[RACER_POD_INDEX]);
+			position.m_partnerMove = CreateMove(pods[BLOCKER_POD_INDEX], commands[BLOCKER_POD_INDEX]);
+			for (int iPod = 0; iPod < POD_TOTAL_NB; iPod++)
+			{
+				Pod& pod = position.m_simulation.m_pods[iPod];
+				pod.m_currentCheckpointIndex = pods[iPod].m_nextCheckpointIndex;
+				pod.m_checkpointPassedCount = pods[iPod].m_checkpointPassedCount;
+				pod.m_usedBoost = pods[iPod].m_usedBoost;
+				pod.m_shieldCooldown = pods[iPod].m_shieldCooldown;
+				if (iPod < POD_CONTROLLABLE_NB) continue;
+
+				RefereePod commandedPod = pods[iPod];
+				Referee::ApplyCommand(commandedPod, commands[iPod]);
+				Pod& commandedOpponent = position.m_commandedOpponents[iPod - POD_CONTROLLABLE_NB];
+				commandedOpponent = pod;
+				commandedOpponent.m_speed = Vector2((float)commandedPod.m_speedX, (float)commandedPod.m_speedY);
+				commandedOpponent.m_angle = (int)round(commandedPod.m_angle) % 360;
+				commandedOpponent.m_isUsingShield = commandedPod.m_mass > 1.0;
+			}
+
+			const Simulation& positionSimulation = position.m_simulation;
+			const Pod& racer = positionSimulation.m_pods[RACER_POD_INDEX];
+			float distanceToCheckpoint = Vector2::Distance(racer.m_position, positionSimulation.m_checkpoints[racer.m_currentCheckpointIndex].m_position);
+			Simulation playedSimulation;
+			PlayFirstTurn(position, position.m_playedMove, &playedSimulation);
+
+			array<bool, SITUATION_COUNT>& situations = position.m_situations;
+			situations[SITUATION_FIRST_TURN] = iFrame == 0;
+			situations[SITUATION_CHECKPOINT_APPROACH] = (distanceToCheckpoint - CHECKPOINT_RADIUS) / max(racer.m_speed.Magnitude(), 1.0f) < HORIZON_NEAR_CHECKPOINT_TURNS;
+			situations[SITUATION_COLLISION] = playedSimulation.HasCollided();
+			situations[SITUATION_FINAL_LAP] = racer.m_checkpointPassedCount >= positionSimulation.m_checkpointCount_Race - positionSimulation.m_checkpointCount_Lap;
+			situations[SITUATION_OTHER] = find(situations.begin(), situations.end(), true) == situations.end();
+			_positions->push_back(position);
+		}
+	}
+}
+
+#pragma endregion
+
+#pragma region Regret
+
+struct RegretResult
+{
+	int m_regret = 0;
+	bool m_isDisagreeing = false;
+};
+
+bool AreMovesAgreeing(const Move& _move, const Move& _reference)
+{
+	return abs(_move.m_rotation - _reference.m_rotation) <= REGRET_ROTATION_TOLERANCE
+		&& abs(_move.m_thrust - _reference.m_thrust) <= REGRET_THRUST_TOLERANCE
+		&& _move.m_useBoost == _reference.m_useBoost
+		&& _move.m_useShield == _reference.m_useShield;
+}
+
+// Best score of a long search from the given simulation, with a fixed horizon so that the scores of two searches compare
+int SearchScore(Simulation* _simulation, const RegretPosition& _position, SearchParameters _parameters, int _horizon, Move* _firstMove)
+{
+	_parameters.m_nbTurnSimulated = _horizon;
+	_parameters.m_isHorizonAdaptive = false;
+
+	Solution partnerPlan;
+	partnerPlan.m_turns[0].m_moves[BLOCKER_POD_INDEX] = _position.m_partnerMove;
+	partnerPlan.m_nbTurnSimulated = 1;
+
+	Solver solver(_simulation, _parameters, RACER_POD_INDEX);
+	solver.SetPartnerPlan(partnerPlan, 0);
+	const Solution& solution = solver.Solve();
+	if (_firstMove != nullptr) *_firstMove = solution.m_turns[0].m_moves[RACER_POD_INDEX];
+	return solution.m_score;
+}
+
+// Both moves are followed by a long search over the rest of the horizon, ending on the same turn
+RegretResult AnalysePosition(const RegretPosition& _position, const SearchParameters& _parameters, unsigned int _seed)
+{
+	Random::SetSeed(_seed);
+	RegretResult result;
+
+	const int horizon = clamp(_parameters.m_nbTurnSimulated, 2, NB_TURN_SIMULATED_MAX);
+	Simulation simulation = _position.m_simulation;
+	Move referenceMove;
+	SearchScore(&simulation, _position, _parameters, horizon, &referenceMove);
+	if (AreMovesAgreeing(_position.m_playedMove, referenceMove)) return result;
+	result.m_isDisagreeing = true;
+
+	PlayFirstTurn(_position, referenceMove, &simulation);
+	const int referenceScore = SearchScore(&simulation, _position, _parameters, horizon - 1, nullptr);
+	PlayFirstTurn(_position, _position.m_playedMove, &simulation);
+	const int playedScore = SearchScore(&simulation, _position, _parameters, horizon - 1, nullptr);
+
+	// The reference is the best of both, a long search missing the played plan does not make a negative regret.
+	// An endgame solved after one move and not after the other is counted as one checkpoint.
+	result.m_regret = clamp(referenceScore - playedScore, 0, _parameters.m_evaluationCheckpointFactor);
+	return result;
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	if (_argc < 2)
+	{
+		cout << "Usage : RegretAnalysis framesFile [referenceMilliseconds] [turnStride]" << endl;
+		return 1;
+	}
+	const unsigned int threadCount = max(1u, thread::hardware_concurrency());
+	const int referenceMilliseconds = max(_argc > 2 ? atoi(_argv[2]) : REGRET_DEFAULT_REFERENCE_MILLISECONDS, 1);
+	const int turnStride = max(_argc > 3 ? atoi(_argv[3]) : REGRET_DEFAULT_TURN_STRIDE, 1);
+
+	const vector<RecordedGame> games = ReadGames(_argv[1]);
+	vector<RegretPosition> positions;
+	for (const RecordedGame& game : games) CreatePositions(game, turnStride, &positions);
+
+	SearchParameters parameters;
+	parameters.m_timeAllocatedPerTurn = referenceMilliseconds;
+	cout << "Re-solving " << positions.size() << " turns of " << games.size() << " games at " << referenceMilliseconds << "ms per search ("
+		<< fixed << setprecision(1) << (double)referenceMilliseconds / TIME_ALLOCATED_PER_TURN << "x the arena budget) on " << threadCount << " threads" << endl;
+
+	vector<RegretResult> results(positions.size());
+	atomic<int> nextPosition(0);
+	auto worker = [&]()
+	{
+		for (int iPosition = nextPosition++; iPosition < (int)positions.size(); iPosition = nextPosition++)
+		{
+			results[iPosition] = AnalysePosition(positions[iPosition], parameters, REGRET_SEED + (unsigned int)iPosition);
+		}
+	};
+	vector<thread> threads;
+	for (unsigned int iThread = 0; iThread < threadCount; iThread++) threads.emplace_back(worker);
+	for (thread& workerThread : threads) workerThread.join();
+
+	long long totalRegret = 0;
+	for (const RegretResult& result : results) totalRegret += result.m_regret;
+
+	// Where the regret is spent tells which situations deserve a faster search
+	cout << "situation,turns,disagreement,meanRegret,maximumRegret,regretShare" << endl;
+	for (int iSituation = 0; iSituation < SITUATION_COUNT; iSituation++)
+	{
+		int turnCount = 0;
+		int disagreementCount = 0;
+		long long regret = 0;
+		int maximumRegret = 0;
+		for (size_t iPosition = 0; iPosition < positions.size(); iPosition++)
+		{
+			if (false == positions[iPosition].m_situations[iSituation]) continue;
+			const RegretResult& result = results[iPosition];
+			turnCount++;
+			if (result.m_isDisagreeing) disagreementCount++;
+			regret += result.m_regret;
+			maximumRegret = max(maximumRegret, result.m_regret);
+		}
+
+		const double turns = max(turnCount, 1);
+		cout << SITUATION_NAMES[iSituation] << "," << turnCount << "," << fixed << setprecision(3) << disagreementCount / turns << ","
+			<< setprecision(1) << regret / turns << "," << maximumRegret << "," << setprecision(3) << (double)regret / max(totalRegret, 1ll) << endl;
+	}
+	cout << "all," << positions.size() << ",," << setprecision(1) << (double)totalRegret / max((int)positions.size(), 1) << ",," << endl;
+}
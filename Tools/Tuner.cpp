@@ -0,0 +1,208 @@
+// SPSA tuning of the Gold.cpp search constants through in-process self-play.
+// Build : g++ -std=c++17 -O2 -pthread Tools/Tuner.cpp Tools/Referee.cpp -o Tuner
+// Usage : Tuner [iterations] [gamesPerIteration] [millisecondsPerTurn] [outputHeader]
+// The output header is picked up by Gold.cpp when it sits next to it, paste its content in place of the defaults for the submission.
+
+#define GOLD_NO_MAIN
+#define GOLD_SILENT
+#include "../Gold.cpp"
+
+#include "Referee.h"
+#include "GoldPlayer.h"
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#define TUNER_DEFAULT_ITERATIONS 2000
+#define TUNER_DEFAULT_MILLISECONDS_PER_TURN 5
+#define TUNER_DEFAULT_OUTPUT "GoldParameters.h"
+#define TUNER_SAVE_FREQUENCY 20
+
+// Standard SPSA gain sequences exponents
+#define TUNER_LEARNING_RATE_DECAY 0.602
+#define TUNER_PERTURBATION_DECAY 0.101
+
+#pragma region Tuned Parameters
+
+struct TunedParameter
+{
+	const char* m_name;
+	int SearchParameters::* m_field;
+	double m_minimum;
+	double m_maximum;
+	double m_perturbation; // SPSA c value, in parameter units
+	double m_value;
+};
+
+vector<TunedParameter> CreateTunedParameters()
+{
+	SearchParameters defaults;
+	return
+	{
+		{ "PROBABILITY_TO_USE_BOOST", &SearchParameters::m_probabilityToUseBoost, 0.0, 100.0, 6.0, 0.0 },
+		{ "PROBABILITY_TO_FULL_THROTTLE", &SearchParameters::m_probabilityToFullThrottle, 0.0, 100.0, 6.0, 0.0 },
+		{ "PROBABILITY_TO_NO_THROTTLE", &SearchParameters::m_probabilityToNoThrottle, 0.0, 100.0, 6.0, 0.0 },
+		{ "EVALUATION_CHECKPOINT_FACTOR", &SearchParameters::m_evaluationCheckpointFactor, 5000.0, 200000.0, 5000.0, 0.0 },
+		{ "SOLUTIONS_COUNT", &SearchParameters::m_solutionsCount, 1.0, 64.0, 2.0, 0.0 },
+		{ "NB_TURN_SIMULATED", &SearchParameters::m_nbTurnSimulated, 1.0, NB_TURN_SIMULATED_MAX, 1.0, 0.0 },
+	};
+}
+
+SearchParameters BuildSearchParameters(const vector<TunedParameter>& _tunedParameters, const vector<double>& _values, int _millisecondsPerTurn)
+{
+	SearchParameters parameters;
+	for (size_t iParameter = 0; iParameter < _tunedParameters.size(); iParameter++)
+	{
+		parameters.*(_tunedParameters[iParameter].m_field) = (int)round(_values[iParameter]);
+	}
+	// Thresholds are cumulative
+	parameters.m_probabilityToNoThrottle = max(parameters.m_probabilityToNoThrottle, parameters.m_probabilityToFullThrottle);
+	parameters.m_timeAllocatedPerTurn = _millisecondsPerTurn;
+	parameters.m_mapAnalysisTime = MAP_ANALYSIS_TIME * _millisecondsPerTurn / TIME_ALLOCATED_PER_TURN; // Same share of the game as in the arena
+	return parameters;
+}
+
+void WriteHeader(const string& _path, const vector<TunedParameter>& _tunedParameters, int _iterations, long long _games)
+{
+	SearchParameters parameters = BuildSearchParameters(_tunedParameters, [&]()
+	{
+		vector<double> values;
+		for (const TunedParameter& tunedParameter : _tunedParameters) values.push_back(tunedParameter.m_value);
+		return values;
+	}(), TIME_ALLOCATED_PER_TURN);
+
+	ofstream file(_path);
+	file << "#pragma once" << endl << endl;
+	file << "// Generated by Tools/Tuner.cpp after " << _iterations << " iterations and " << _games << " games" << endl << endl;
+	for (const TunedParameter& tunedParameter : _tunedParameters)
+	{
+		file << "#define " << tunedParameter.m_name << " " << parameters.*(tunedParameter.m_field) << endl;
+	}
+}
+
+#pragma endregion
+
+#pragma region Self Play
+
+// Returns the winning player, -1 on a draw
+int PlayGame(const SearchParameters& _parametersPlayer0, const SearchParameters& _parametersPlayer1, int _mapIndex, unsigned int _seed)
+{
+	Random::SetSeed(_seed);
+
+	Referee referee;
+	referee.Initialize(_mapIndex, _seed);
+
+	GoldPlayer player0(_parametersPlayer0);
+	GoldPlayer player1(_parametersPlayer1);
+	player0.Initialize(referee);
+	player1.Initialize(referee);
+
+	while (false == referee.IsOver())
+	{
+		array<RefereeCommand, REFEREE_POD_PER_PLAYER> commandsPlayer0 = player0.PlayTurn(referee.GetPodsInputs(0));
+		array<RefereeCommand, REFEREE_POD_PER_PLAYER> commandsPlayer1 = player1.PlayTurn(referee.GetPodsInputs(1));
+		referee.PlayTurn(commandsPlayer0, commandsPlayer1);
+	}
+	return referee.GetWinner();
+}
+
+// Plays the batch on every core, games are played in pairs on the same map with swapped sides.
+// Returns the mean result from the point of view of the plus parameters, between -1 and 1.
+double PlayBatch(const SearchParameters& _parametersPlus, const SearchParameters& _parametersMinus, int _gameCount, unsigned int _seed)
+{
+	vector<int> results(_gameCount, 0);
+	atomic<int> nextGame(0);
+
+	auto worker = [&]()
+	{
+		for (int iGame = nextGame++; iGame < _gameCount; iGame = nextGame++)
+		{
+			const int pairIndex = iGame / 2;
+			const unsigned int gameSeed = _seed + (unsigned int)pairIndex * 7919u;
+			const int mapIndex = (int)(gameSeed % (unsigned int)Referee::GetMapCount());
+			const bool plusIsPlayer0 = (iGame % 2) == 0;
+
+			int winner = plusIsPlayer0 ?
+				PlayGame(_parametersPlus, _parametersMinus, mapIndex, gameSeed) :
+				PlayGame(_parametersMinus, _parametersPlus, mapIndex, gameSeed);
+
+			if (winner < 0) results[iGame] = 0;
+			else results[iGame] = ((winner == 0) == plusIsPlayer0) ? 1 : -1;
+		}
+	};
+
+	unsigned int threadCount = max(1u, thread::hardware_concurrency());
+	vector<thread> threads;
+	for (unsigned int iThread = 0; iThread < threadCount; iThread++) threads.emplace_back(worker);
+	for (thread& workerThread : threads) workerThread.join();
+
+	double sum = 0.0;
+	for (int result : results) sum += result;
+	return sum / _gameCount;
+}
+
+#pragma endregion
+
+int main(int _argc, char** _argv)
+{
+	const unsigned int threadCount = max(1u, thread::hardware_concurrency());
+	const int iterations = _argc > 1 ? atoi(_argv[1]) : TUNER_DEFAULT_ITERATIONS;
+	int gamesPerIteration = _argc > 2 ? atoi(_argv[2]) : (int)max(8u, threadCount * 2);
+	const int millisecondsPerTurn = _argc > 3 ? atoi(_argv[3]) : TUNER_DEFAULT_MILLISECONDS_PER_TURN;
+	const string outputPath = _argc > 4 ? _argv[4] : TUNER_DEFAULT_OUTPUT;
+	gamesPerIteration += gamesPerIteration % 2;
+
+	vector<TunedParameter> tunedParameters = CreateTunedParameters();
+	SearchParameters defaults;
+	for (TunedParameter& tunedParameter : tunedParameters) tunedParameter.m_value = defaults.*(tunedParameter.m_field);
+
+	cout << "Tuning " << tunedParameters.size() << " parameters, " << iterations << " iterations of " << gamesPerIteration
+		<< " games at " << millisecondsPerTurn << "ms per turn on " << threadCount << " threads" << endl;
+
+	// Gains are chosen so that a decisive batch moves every parameter by about its perturbation at the start
+	const double stabilityConstant = iterations * 0.1;
+	const double learningRate = pow(stabilityConstant + 1.0, TUNER_LEARNING_RATE_DECAY);
+
+	mt19937 generator(12345);
+	long long gamesPlayed = 0;
+	for (int iIteration = 0; iIteration < iterations; iIteration++)
+	{
+		const double learningRateIteration = learningRate / pow(stabilityConstant + iIteration + 1.0, TUNER_LEARNING_RATE_DECAY);
+		const double perturbationScale = 1.0 / pow(iIteration + 1.0, TUNER_PERTURBATION_DECAY);
+
+		vector<double> directions;
+		vector<double> valuesPlus;
+		vector<double> valuesMinus;
+		for (const TunedParameter& tunedParameter : tunedParameters)
+		{
+			double direction = (generator() % 2) ? 1.0 : -1.0;
+			double perturbation = max(tunedParameter.m_perturbation * perturbationScale, 1.0);
+			directions.push_back(direction);
+			valuesPlus.push_back(clamp(tunedParameter.m_value + direction * perturbation, tunedParameter.m_minimum, tunedParameter.m_maximum));
+			valuesMinus.push_back(clamp(tunedParameter.m_value - direction * perturbation, tunedParameter.m_minimum, tunedParameter.m_maximum));
+		}
+
+		double result = PlayBatch(
+			BuildSearchParameters(tunedParameters, valuesPlus, millisecondsPerTurn),
+			BuildSearchParameters(tunedParameters, valuesMinus, millisecondsPerTurn),
+			gamesPerIteration, generator());
+		gamesPlayed += gamesPerIteration;
+
+		cout << "Iteration " << iIteration + 1 << " result " << result << " :";
+		for (size_t iParameter = 0; iParameter < tunedParameters.size(); iParameter++)
+		{
+			TunedParameter& tunedParameter = tunedParameters[iParameter];
+			double step = learningRateIteration * tunedParameter.m_perturbation * perturbationScale * result * directions[iParameter];
+			tunedParameter.m_value = clamp(tunedParameter.m_value + step, tunedParameter.m_minimum, tunedParameter.m_maximum);
+			cout << " " << tunedParameter.m_name << "=" << tunedParameter.m_value;
+		}
+		cout << endl;
+
+		if ((iIteration + 1) % TUNER_SAVE_FREQUENCY == 0) WriteHeader(outputPath, tunedParameters, iIteration + 1, gamesPlayed);
+	}
+
+	WriteHeader(outputPath, tunedParameters, iterations, gamesPlayed);
+	cout << "Tuned parameters written to " << outputPath << endl;
+}
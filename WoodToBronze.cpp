@@ -10,6 +10,82 @@ using namespace std;
 #define BOOST_THRESHOLD_ANGLE 1
 #define BOOST_KEYWORD "BOOST"
 
+#define PI 3.141592f
+#define CHECKPOINT_RADIUS 600
+#define POD_MAXIMUM_ROTATION 18.0f
+#define POD_FRICTION 0.85f
+#define POD_BOOST_THRUST 650
+
+#define LEARNED_MAP_MAXIMUM_CHECKPOINTS 8
+
+#define SEARCH_DEPTH 3 // Every move combination is tried up to this depth, then the pod aims at the checkpoints
+#define SEARCH_ROLLOUT_TURNS 3
+#define SEARCH_ROLLOUT_SPEED_OFFSET 3.0f
+#define SEARCH_CHECKPOINT_SCORE 50000.0f
+#define SEARCH_LATE_PASS_PENALTY 1000.0f // Per turn, without it the pod keeps postponing a checkpoint it can pass anyway
+#define SEARCH_TARGET_DISTANCE 10000.0f
+
+#define DEG_TO_RAD(angleDeg) ((angleDeg) * PI / 180.0f)
+#define RAD_TO_DEG(angleRad) ((angleRad) * 180.0f / PI)
+
+#ifdef WOOD_TO_BRONZE_SILENT
+#define DEBUG_LOG if (true) {} else cerr
+#else
+#define DEBUG_LOG cerr
+#endif
+
+#pragma region Input and Output Structures
+
+struct TurnInput
+{
+	int m_x = 0;
+	int m_y = 0;
+	int m_nextCheckpointX = 0;
+	int m_nextCheckpointY = 0;
+	int m_nextCheckpointDistance = 0;
+	int m_nextCheckpointAngle = 0;
+	int m_opponentX = 0;
+	int m_opponentY = 0;
+};
+
+struct PodCommand
+{
+	int m_targetX = 0;
+	int m_targetY = 0;
+	int m_thrust = 0;
+	bool m_useBoost = false;
+};
+
+#pragma endregion
+
+#pragma region Stream Adapter
+
+TurnInput ReadTurnInput(istream& _stream)
+{
+	TurnInput turnInput;
+	_stream >> turnInput.m_x >> turnInput.m_y >>
+		turnInput.m_nextCheckpointX >> turnInput.m_nextCheckpointY >>
+		turnInput.m_nextCheckpointDistance >> turnInput.m_nextCheckpointAngle;
+	_stream.ignore();
+	_stream >> turnInput.m_opponentX >> turnInput.m_opponentY;
+	_stream.ignore();
+	return turnInput;
+}
+
+void WriteCommand(ostream& _stream, const PodCommand& _command)
+{
+	if (_command.m_useBoost)
+	{
+		_stream << _command.m_targetX << " " << _command.m_targetY << " " << BOOST_KEYWORD << endl;
+	}
+	else
+	{
+		_stream << _command.m_targetX << " " << _command.m_targetY << " " << _command.m_thrust << endl;
+	}
+}
+
+#pragma endregion
+
 #pragma region Checkpoint
 
 struct Checkpoint
@@ -22,12 +98,207 @@ struct Checkpoint
 
 #pragma endregion
 
+#pragma region Learned Map
+
+// The league only gives the next checkpoint, the map is recorded while the first lap is raced
+class LearnedMap
+{
+public:
+	void Record(int _x, int _y);
+	int FindIndex(int _x, int _y) const;
+
+	bool IsComplete() const { return m_isComplete; }
+	const Checkpoint& GetCheckpoint(int _index) const { return m_checkpoints[_index % m_count]; }
+
+private:
+	Checkpoint m_checkpoints[LEARNED_MAP_MAXIMUM_CHECKPOINTS];
+	int m_count = 0;
+	bool m_isComplete = false;
+};
+
+void LearnedMap::Record(int _x, int _y)
+{
+	if (m_isComplete) return;
+	if (m_count > 0 && m_checkpoints[m_count - 1].m_x == _x && m_checkpoints[m_count - 1].m_y == _y) return;
+
+	// The lap is closed when the first recorded checkpoint comes back
+	if (m_count > 1 && m_checkpoints[0].m_x == _x && m_checkpoints[0].m_y == _y)
+	{
+		m_isComplete = true;
+		return;
+	}
+	if (m_count == LEARNED_MAP_MAXIMUM_CHECKPOINTS) return;
+	m_checkpoints[m_count].m_x = _x;
+	m_checkpoints[m_count].m_y = _y;
+	m_count++;
+}
+
+int LearnedMap::FindIndex(int _x, int _y) const
+{
+	for (int iCheckpoint = 0; iCheckpoint < m_count; iCheckpoint++)
+	{
+		if (m_checkpoints[iCheckpoint].m_x == _x && m_checkpoints[iCheckpoint].m_y == _y) return iCheckpoint;
+	}
+	return 0;
+}
+
+#pragma endregion
+
+#pragma region Race Search
+
+float NormalizeAngle(float _angle)
+{
+	while (_angle > 180.0f) _angle -= 360.0f;
+	while (_angle <= -180.0f) _angle += 360.0f;
+	return _angle;
+}
+
+// Rotation the referee applies to face the target, in degres
+float ComputeRotation(float _facingAngle, float _x, float _y, float _targetX, float _targetY)
+{
+	if (_x == _targetX && _y == _targetY) return 0.0f;
+	float targetAngle = RAD_TO_DEG(atan2f(_targetY - _y, _targetX - _x));
+	return clamp(NormalizeAngle(targetAngle - _facingAngle), -POD_MAXIMUM_ROTATION, POD_MAXIMUM_ROTATION);
+}
+
+struct SearchPod
+{
+	float m_x = 0.0f;
+	float m_y = 0.0f;
+	float m_speedX = 0.0f;
+	float m_speedY = 0.0f;
+	float m_angle = 0.0f;
+	int m_nextCheckpointIndex = 0;
+	int m_checkpointPassedCount = 0;
+	int m_turn = 0;
+	int m_lastPassTurn = 0;
+};
+
+struct SearchMove
+{
+	float m_rotation = 0.0f;
+	int m_thrust = 0;
+};
+
+// Exhaustive search of the next moves on the learned map, the opponent is ignored.
+// A few thousand pod steps, far below a millisecond.
+class RaceSearch
+{
+public:
+	static PodCommand FindCommand(const LearnedMap& _map, const SearchPod& _pod, bool _canUseBoost);
+
+private:
+	static float SearchMoves(const LearnedMap& _map, const SearchPod& _pod, int _depth);
+	static void SimulateTurn(const LearnedMap& _map, SearchPod& _pod, const SearchMove& _move);
+	static float Evaluate(const LearnedMap& _map, const SearchPod& _pod);
+};
+
+const SearchMove SEARCH_MOVES[] =
+{
+	{ -POD_MAXIMUM_ROTATION, 100 }, { 0.0f, 100 }, { POD_MAXIMUM_ROTATION, 100 },
+	{ -POD_MAXIMUM_ROTATION, 50 }, { 0.0f, 50 }, { POD_MAXIMUM_ROTATION, 50 },
+	{ -POD_MAXIMUM_ROTATION, 0 }, { 0.0f, 0 }, { POD_MAXIMUM_ROTATION, 0 },
+};
+
+PodCommand RaceSearch::FindCommand(const LearnedMap& _map, const SearchPod& _pod, bool _canUseBoost)
+{
+	SearchMove bestMove;
+	float bestScore = -INFINITY;
+	bool isBestBoost = false;
+
+	// The boost is only tried on the first move, it is used once per race
+	for (int iMove = -1; iMove < (int)size(SEARCH_MOVES); iMove++)
+	{
+		if (iMove < 0 && false == _canUseBoost) continue;
+		SearchMove move = iMove < 0 ? SearchMove{ 0.0f, POD_BOOST_THRUST } : SEARCH_MOVES[iMove];
+
+		SearchPod pod = _pod;
+		SimulateTurn(_map, pod, move);
+		float score = SearchMoves(_map, pod, 1);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestMove = move;
+			isBestBoost = iMove < 0;
+		}
+	}
+
+	float angle = DEG_TO_RAD(_pod.m_angle + bestMove.m_rotation);
+	PodCommand command;
+	command.m_targetX = (int)(_pod.m_x + cosf(angle) * SEARCH_TARGET_DISTANCE);
+	command.m_targetY = (int)(_pod.m_y + sinf(angle) * SEARCH_TARGET_DISTANCE);
+	command.m_thrust = isBestBoost ? 100 : bestMove.m_thrust;
+	command.m_useBoost = isBestBoost;
+	return command;
+}
+
+float RaceSearch::SearchMoves(const LearnedMap& _map, const SearchPod& _pod, int _depth)
+{
+	if (_depth == SEARCH_DEPTH)
+	{
+		// The end of the horizon is played by the heuristic, aiming at the checkpoints against the speed
+		SearchPod pod = _pod;
+		for (int iTurn = 0; iTurn < SEARCH_ROLLOUT_TURNS; iTurn++)
+		{
+			const Checkpoint& checkpoint = _map.GetCheckpoint(pod.m_nextCheckpointIndex);
+			float targetX = checkpoint.m_x - pod.m_speedX * SEARCH_ROLLOUT_SPEED_OFFSET;
+			float targetY = checkpoint.m_y - pod.m_speedY * SEARCH_ROLLOUT_SPEED_OFFSET;
+			SimulateTurn(_map, pod, SearchMove{ ComputeRotation(pod.m_angle, pod.m_x, pod.m_y, targetX, targetY), 100 });
+		}
+		return Evaluate(_map, pod);
+	}
+
+	float bestScore = -INFINITY;
+	for (const SearchMove& move : SEARCH_MOVES)
+	{
+		SearchPod pod = _pod;
+		SimulateTurn(_map, pod, move);
+		bestScore = max(bestScore, SearchMoves(_map, pod, _depth + 1));
+	}
+	return bestScore;
+}
+
+void RaceSearch::SimulateTurn(const LearnedMap& _map, SearchPod& _pod, const SearchMove& _move)
+{
+	_pod.m_angle = NormalizeAngle(_pod.m_angle + _move.m_rotation);
+	float angle = DEG_TO_RAD(_pod.m_angle);
+	_pod.m_speedX += cosf(angle) * _move.m_thrust;
+	_pod.m_speedY += sinf(angle) * _move.m_thrust;
+	_pod.m_x += _pod.m_speedX;
+	_pod.m_y += _pod.m_speedY;
+
+	const Checkpoint& checkpoint = _map.GetCheckpoint(_pod.m_nextCheckpointIndex);
+	float distanceX = checkpoint.m_x - _pod.m_x;
+	float distanceY = checkpoint.m_y - _pod.m_y;
+	if (distanceX * distanceX + distanceY * distanceY < CHECKPOINT_RADIUS * CHECKPOINT_RADIUS)
+	{
+		_pod.m_nextCheckpointIndex++;
+		_pod.m_checkpointPassedCount++;
+		_pod.m_lastPassTurn = _pod.m_turn;
+	}
+	_pod.m_turn++;
+
+	_pod.m_speedX = truncf(_pod.m_speedX * POD_FRICTION);
+	_pod.m_speedY = truncf(_pod.m_speedY * POD_FRICTION);
+	_pod.m_x = roundf(_pod.m_x);
+	_pod.m_y = roundf(_pod.m_y);
+}
+
+float RaceSearch::Evaluate(const LearnedMap& _map, const SearchPod& _pod)
+{
+	const Checkpoint& checkpoint = _map.GetCheckpoint(_pod.m_nextCheckpointIndex);
+	float distance = hypotf(checkpoint.m_x - _pod.m_x, checkpoint.m_y - _pod.m_y);
+	return _pod.m_checkpointPassedCount * SEARCH_CHECKPOINT_SCORE - _pod.m_lastPassTurn * SEARCH_LATE_PASS_PENALTY - distance;
+}
+
+#pragma endregion
+
 #pragma region Pod
 
 class Pod
 {
 public:
-	virtual void ManageInput();
+	virtual void ManageInput(int _x, int _y);
 	virtual void ManageDebug() {};
 
 protected:
@@ -37,10 +308,10 @@ protected:
 	bool m_canUseBoost = true;
 };
 
-void Pod::ManageInput()
+void Pod::ManageInput(int _x, int _y)
 {
-	cin >> m_x >> m_y;
-	cin.ignore();
+	m_x = _x;
+	m_y = _y;
 }
 
 #pragma endregion
@@ -50,43 +321,101 @@ void Pod::ManageInput()
 class PlayerPod : public Pod
 {
 public:
-	void ManageInput() override;
+	void ManageInput(const TurnInput& _turnInput);
 	void ManageDebug() override;
-	void ManageOutput();
+	PodCommand ManageOutput();
 private:
+	void ManageMap();
 	int ComputeThrust();
 	bool CheckShouldBoost();
 
 	Checkpoint m_nextCheckpoint;
+	LearnedMap m_map;
+	int m_lastX = 0;
+	int m_lastY = 0;
+	int m_targetX = 0;
+	int m_targetY = 0;
+	float m_facingAngle = 0.0f;
+	bool m_isFirstFrame = true;
 };
 
-void PlayerPod::ManageInput()
+void PlayerPod::ManageInput(const TurnInput& _turnInput)
+{
+	m_x = _turnInput.m_x;
+	m_y = _turnInput.m_y;
+	m_nextCheckpoint.m_x = _turnInput.m_nextCheckpointX;
+	m_nextCheckpoint.m_y = _turnInput.m_nextCheckpointY;
+	m_nextCheckpoint.m_distance = _turnInput.m_nextCheckpointDistance;
+	m_nextCheckpoint.m_angle = _turnInput.m_nextCheckpointAngle;
+	ManageMap();
+}
+
+void PlayerPod::ManageMap()
 {
-	cin >> m_x >> m_y >>
-		m_nextCheckpoint.m_x >> m_nextCheckpoint.m_y >>
-		m_nextCheckpoint.m_distance >> m_nextCheckpoint.m_angle;
-	cin.ignore();
+	m_map.Record(m_nextCheckpoint.m_x, m_nextCheckpoint.m_y);
+
+	// The facing is not given, it comes back from the signed angle to the checkpoint.
+	// Both signs are tried, the one closest to the rotation of the last turn is kept.
+	float checkpointAngle = RAD_TO_DEG(atan2f((float)(m_nextCheckpoint.m_y - m_y), (float)(m_nextCheckpoint.m_x - m_x)));
+	float facingAngle = NormalizeAngle(checkpointAngle - m_nextCheckpoint.m_angle);
+	float mirroredFacingAngle = NormalizeAngle(checkpointAngle + m_nextCheckpoint.m_angle);
+	if (false == m_isFirstFrame)
+	{
+		float predictedAngle = m_facingAngle + ComputeRotation(m_facingAngle, (float)m_lastX, (float)m_lastY, (float)m_targetX, (float)m_targetY);
+		if (abs(NormalizeAngle(mirroredFacingAngle - predictedAngle)) < abs(NormalizeAngle(facingAngle - predictedAngle)))
+		{
+			facingAngle = mirroredFacingAngle;
+		}
+	}
+	m_facingAngle = facingAngle;
 }
 
 void PlayerPod::ManageDebug()
 {
-	cerr << "Thrust : " << m_thrust << endl;
-	cerr << "Can use boost : " << m_canUseBoost << endl;
-	cerr << "Distance to checkpoint : " << m_nextCheckpoint.m_distance << endl;
-	cerr << "Angle to checkpoint : " << m_nextCheckpoint.m_angle << endl;
+	DEBUG_LOG << "Thrust : " << m_thrust << endl;
+	DEBUG_LOG << "Can use boost : " << m_canUseBoost << endl;
+	DEBUG_LOG << "Distance to checkpoint : " << m_nextCheckpoint.m_distance << endl;
+	DEBUG_LOG << "Angle to checkpoint : " << m_nextCheckpoint.m_angle << endl;
 }
 
-void PlayerPod::ManageOutput()
+PodCommand PlayerPod::ManageOutput()
 {
-	if (CheckShouldBoost())
+	PodCommand command;
+
+	// From the second lap the whole map is known, the moves are searched instead
+	if (false == m_isFirstFrame && m_map.IsComplete())
 	{
-		cout << m_nextCheckpoint.m_x << " " << m_nextCheckpoint.m_y << " " << BOOST_KEYWORD << endl;
+		SearchPod pod;
+		pod.m_x = (float)m_x;
+		pod.m_y = (float)m_y;
+		pod.m_speedX = truncf((m_x - m_lastX) * POD_FRICTION);
+		pod.m_speedY = truncf((m_y - m_lastY) * POD_FRICTION);
+		pod.m_angle = m_facingAngle;
+		pod.m_nextCheckpointIndex = m_map.FindIndex(m_nextCheckpoint.m_x, m_nextCheckpoint.m_y);
+
+		command = RaceSearch::FindCommand(m_map, pod, m_canUseBoost);
+		if (command.m_useBoost) m_canUseBoost = false;
+		m_thrust = command.m_thrust;
 	}
 	else
 	{
-		m_thrust = ComputeThrust();
-		cout << m_nextCheckpoint.m_x << " " << m_nextCheckpoint.m_y << " " << m_thrust << endl;
+		command.m_targetX = m_nextCheckpoint.m_x;
+		command.m_targetY = m_nextCheckpoint.m_y;
+		command.m_useBoost = CheckShouldBoost();
+		if (false == command.m_useBoost)
+		{
+			m_thrust = ComputeThrust();
+			command.m_thrust = m_thrust;
+		}
 	}
+
+	// Kept to estimate the speed and the facing on the next turn
+	m_lastX = m_x;
+	m_lastY = m_y;
+	m_targetX = command.m_targetX;
+	m_targetY = command.m_targetY;
+	m_isFirstFrame = false;
+	return command;
 }
 
 int PlayerPod::ComputeThrust() 
@@ -120,18 +449,49 @@ bool PlayerPod::CheckShouldBoost()
 
 #pragma endregion
 
+#pragma region Wood Bot
+
+// The whole bot behind an init/step interface on plain structures, main only adapts it to the referee streams
+class WoodBot
+{
+public:
+	void Init(); // These leagues give no map, it only forgets the previous race
+	PodCommand Step(const TurnInput& _turnInput);
+
+private:
+	PlayerPod m_playerPod;
+	Pod m_opponent;
+};
+
+void WoodBot::Init()
+{
+	m_playerPod = PlayerPod();
+	m_opponent = Pod();
+}
+
+PodCommand WoodBot::Step(const TurnInput& _turnInput)
+{
+	m_playerPod.ManageInput(_turnInput);
+	m_opponent.ManageInput(_turnInput.m_opponentX, _turnInput.m_opponentY);
+	m_playerPod.ManageDebug();
+	return m_playerPod.ManageOutput();
+}
+
+#pragma endregion
+
+#ifndef WOOD_TO_BRONZE_NO_MAIN // Tools embed this file and drive WoodBot themselves
+
 int main()
 {
-	PlayerPod playerPod;
-	Pod opponent;
+	WoodBot bot;
+	bot.Init();
 
 	// Game loop
 	bool isRunning = true;
 	while (isRunning)
 	{
-		playerPod.ManageInput();
-		opponent.ManageInput();
-		playerPod.ManageDebug();
-		playerPod.ManageOutput();
+		WriteCommand(cout, bot.Step(ReadTurnInput(cin)));
 	}
 }
+
+#endif